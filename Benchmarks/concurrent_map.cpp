@@ -0,0 +1,114 @@
+//====================
+// concurrent_map.cpp
+//====================
+
+// Write-scalability of concurrent_map compared to shared_map with 1 to 64 threads.
+// Writers run in parallel in different groups of the latched level,
+// up to 64 groups are latched separately.
+
+// Copyright 2026, Sven Bieg (svenbieg@outlook.de)
+// https://github.com/svenbieg/Clusters/wiki/Map
+
+
+//=======
+// Using
+//=======
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+#include "Collections/concurrent_map.hpp"
+#include "Collections/shared_map.hpp"
+
+using namespace Collections;
+
+
+//==========
+// Settings
+//==========
+
+constexpr uint32_t KEY_COUNT=1000000;
+constexpr uint32_t OPERATION_COUNT=2000000;
+
+
+//========
+// Common
+//========
+
+template <class _map_t> static double run(_map_t& map, unsigned int thread_count)
+{
+// Three sets, one remove and four lookups of random keys per eight operations.
+std::vector<std::thread> threads;
+auto start=std::chrono::steady_clock::now();
+for(unsigned int t=0; t<thread_count; t++)
+	{
+	threads.emplace_back([&map, t, thread_count]()
+		{
+		uint32_t seed=t*2654435761u+1;
+		uint32_t count=OPERATION_COUNT/thread_count;
+		for(uint32_t u=0; u<count; u++)
+			{
+			seed=seed*1103515245u+12345u;
+			uint32_t key=(seed>>8)%KEY_COUNT;
+			switch(u%8)
+				{
+				case 0:
+				case 1:
+				case 2:
+					{
+					map.set(key, u);
+					break;
+					}
+				case 3:
+					{
+					map.remove(key);
+					break;
+					}
+				default:
+					{
+					uint32_t value=0;
+					map.try_get(key, &value);
+					break;
+					}
+				}
+			}
+		});
+	}
+for(auto& thread: threads)
+	thread.join();
+auto end=std::chrono::steady_clock::now();
+double seconds=std::chrono::duration<double>(end-start).count();
+return OPERATION_COUNT/seconds/1000000.0;
+}
+
+template <class _map_t> static void fill(_map_t& map)
+{
+for(uint32_t key=0; key<KEY_COUNT; key+=2)
+	map.set(key, key);
+}
+
+
+//======
+// Main
+//======
+
+int main(int argc, char* argv[])
+{
+unsigned int max_threads=64;
+if(argc>1)
+	max_threads=(unsigned int)atoi(argv[1]);
+printf("threads  shared_map  concurrent_map  (million operations per second)\n");
+for(unsigned int thread_count=1; thread_count<=max_threads; thread_count*=2)
+	{
+	shared_map<uint32_t, uint32_t> shared;
+	fill(shared);
+	double shared_speed=run(shared, thread_count);
+	concurrent_map<uint32_t, uint32_t> concurrent;
+	fill(concurrent);
+	double concurrent_speed=run(concurrent, thread_count);
+	printf("%7u  %10.2f  %14.2f\n", thread_count, shared_speed, concurrent_speed);
+	}
+return 0;
+}
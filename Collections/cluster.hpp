@@ -15,11 +15,17 @@
 // Using
 //=======
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <new>
 #include <stdexcept>
 #include <stdint.h>
 #include <type_traits>
 #include <utility>
+#include <vector>
+#include "Collections/cluster_parallel.hpp"
+#include "Collections/cluster_pool.hpp"
 
 
 //===========
@@ -36,6 +42,190 @@ namespace Collections {
 template <class _traits_t, bool _is_const> class cluster_iterator_base;
 
 
+//===========
+// Allocator
+//===========
+
+template <class _traits_t>
+class cluster_allocator
+{
+public:
+	// Using
+	using _alloc_t=typename _traits_t::alloc_t;
+	using _group_t=typename _traits_t::group_t;
+	using _item_group_t=typename _traits_t::item_group_t;
+	using _parent_group_t=typename _traits_t::parent_group_t;
+
+	// Allocation
+	template <class _create_t, class... _args_t> static _create_t* create(_alloc_t& alloc, _args_t&&... args)
+		{
+		void* buf=alloc.allocate(sizeof(_create_t), alignof(_create_t));
+		try
+			{
+			return new (buf) _create_t(std::forward<_args_t>(args)...);
+			}
+		catch(...)
+			{
+			alloc.deallocate(buf, sizeof(_create_t), alignof(_create_t));
+			throw;
+			}
+		}
+	static _group_t* create_group(_alloc_t& alloc, uint16_t level)
+		{
+		if(level>0)
+			return create<_parent_group_t>(alloc, level);
+		return create<_item_group_t>(alloc);
+		}
+	static _group_t* clone_group(_alloc_t& alloc, _group_t const* group)
+		{
+		// Children of parent-groups are shared.
+		if(group->get_level()==0)
+			return create<_item_group_t>(alloc, *(_item_group_t const*)group);
+		auto parent_group=(_parent_group_t const*)group;
+		auto children=parent_group->get_children();
+		uint16_t child_count=parent_group->get_child_count();
+		auto clone=create<_parent_group_t>(alloc, group->get_level());
+		parent_group->set_shared();
+		try
+			{
+			for(uint16_t u=0; u<child_count; u++)
+				{
+				auto child=share_group(alloc, children[u]);
+				clone->insert_groups(u, &child, 1);
+				}
+			}
+		catch(...)
+			{
+			free_group(alloc, clone);
+			throw;
+			}
+		return clone;
+		}
+	static _group_t* copy_group(_alloc_t& alloc, _group_t const* group)
+		{
+		if(group->get_level()>0)
+			return create<_parent_group_t>(alloc, alloc, *(_parent_group_t const*)group);
+		return create<_item_group_t>(alloc, *(_item_group_t const*)group);
+		}
+	static _group_t* copy_tree(_alloc_t& alloc, _group_t const* group)
+		{
+		if constexpr(cluster_alloc_parallel<_alloc_t>::value)
+			{
+			if(group->get_level()>0&&group->get_item_count()>=_parallel_count)
+				return copy_parallel(alloc, group);
+			}
+		return copy_group(alloc, group);
+		}
+	static void free_group(_alloc_t& alloc, _group_t* group)noexcept
+		{
+		if(!group->release())
+			return;
+		if(group->get_level()>0)
+			{
+			auto parent_group=(_parent_group_t*)group;
+			auto children=parent_group->get_children();
+			uint16_t child_count=parent_group->get_child_count();
+			for(uint16_t u=0; u<child_count; u++)
+				free_group(alloc, children[u]);
+			parent_group->~_parent_group_t();
+			alloc.deallocate(parent_group, sizeof(_parent_group_t), alignof(_parent_group_t));
+			return;
+			}
+		auto item_group=(_item_group_t*)group;
+		item_group->~_item_group_t();
+		alloc.deallocate(item_group, sizeof(_item_group_t), alignof(_item_group_t));
+		}
+	static _group_t* share_group(_alloc_t& alloc, _group_t* group)
+		{
+		if(group->acquire())
+			return group;
+		return copy_group(alloc, group);
+		}
+	static _group_t* unshare_group(_alloc_t& alloc, _group_t* group)
+		{
+		if(!group->is_shared())
+			return group;
+		auto clone=clone_group(alloc, group);
+		free_group(alloc, group);
+		return clone;
+		}
+
+private:
+	// Settings
+	static const uint32_t _parallel_count=cluster_parallel::block_size*4;
+
+	// Common
+	// Subtrees of the highest level with enough groups are copied by the threads.
+	static _group_t* copy_parallel(_alloc_t& alloc, _group_t const* root)
+		{
+		unsigned int thread_count=cluster_parallel::get_thread_count(0, UINT32_MAX);
+		std::vector<_group_t const*> sources(1, root);
+		uint16_t level=root->get_level();
+		while(level>0&&sources.size()<thread_count*4)
+			{
+			std::vector<_group_t const*> children;
+			for(auto source: sources)
+				{
+				auto parent_group=(_parent_group_t const*)source;
+				auto source_children=parent_group->get_children();
+				uint16_t child_count=parent_group->get_child_count();
+				children.insert(children.end(), source_children, source_children+child_count);
+				}
+			sources.swap(children);
+			level--;
+			}
+		if(sources.size()<2)
+			return copy_group(alloc, root);
+		thread_count=cluster_parallel::get_thread_count(thread_count, sources.size());
+		std::vector<_alloc_t> allocs(thread_count, alloc);
+		std::vector<_group_t*> copies(sources.size(), nullptr);
+		auto task=[&sources, &allocs, &copies](unsigned int thread, uint64_t task)
+			{
+			copies[task]=copy_group(allocs[thread], sources[task]);
+			};
+		size_t next=0;
+		try
+			{
+			cluster_parallel::run_tasks(sources.size(), thread_count, task);
+			return copy_upper(alloc, root, level, copies.data(), &next);
+			}
+		catch(...)
+			{
+			for(size_t u=next; u<copies.size(); u++)
+				{
+				if(copies[u])
+					free_group(alloc, copies[u]);
+				}
+			throw;
+			}
+		}
+	static _group_t* copy_upper(_alloc_t& alloc, _group_t const* group, uint16_t level, _group_t** copies, size_t* next_ptr)
+		{
+		uint16_t group_level=group->get_level();
+		if(group_level==level)
+			return copies[(*next_ptr)++];
+		auto parent_group=(_parent_group_t const*)group;
+		auto children=parent_group->get_children();
+		uint16_t child_count=parent_group->get_child_count();
+		auto copy=create<_parent_group_t>(alloc, group_level);
+		try
+			{
+			for(uint16_t u=0; u<child_count; u++)
+				{
+				auto child=copy_upper(alloc, children[u], level, copies, next_ptr);
+				copy->insert_groups(u, &child, 1);
+				}
+			}
+		catch(...)
+			{
+			free_group(alloc, copy);
+			throw;
+			}
+		return copy;
+		}
+};
+
+
 //=======
 // Group
 //=======
@@ -45,21 +235,110 @@ class cluster_group
 {
 public:
 	// Using
+	using _alloc_t=typename _traits_t::alloc_t;
 	using _item_t=typename _traits_t::item_t;
+	using _group_t=typename _traits_t::group_t;
+	using _item_group_t=typename _traits_t::item_group_t;
+	using _parent_group_t=typename _traits_t::parent_group_t;
 	using _size_t=typename _traits_t::size_t;
 
-	// Con-Destructors
-	virtual ~cluster_group()noexcept {}
-
 	// Access
-	virtual _item_t& get_at(_size_t position)=0;
-	virtual _item_t const& get_at(_size_t position)const=0;
-	virtual uint16_t get_child_count()const noexcept=0;
-	virtual _size_t get_item_count()const noexcept=0;
-	virtual uint16_t get_level()const noexcept=0;
+	template <class _func_t> bool for_each_chunk(_size_t position, _size_t count, _func_t& func)
+		{
+		if(m_level==0)
+			{
+			auto items=((_item_group_t*)this)->get_items();
+			return func(&items[position], (uint16_t)count);
+			}
+		return ((_parent_group_t*)this)->for_each_chunk(position, count, func);
+		}
+	_item_t& get_at(_size_t position)
+		{
+		if(m_level==0)
+			return ((_item_group_t*)this)->get_at(position);
+		return ((_parent_group_t*)this)->get_at(position);
+		}
+	_item_t const& get_at(_size_t position)const
+		{
+		if(m_level==0)
+			return ((_item_group_t const*)this)->get_at(position);
+		return ((_parent_group_t const*)this)->get_at(position);
+		}
+	inline uint16_t get_child_count()const noexcept
+		{
+		if(m_level==0)
+			return ((_item_group_t const*)this)->get_child_count();
+		return ((_parent_group_t const*)this)->get_child_count();
+		}
+	inline _size_t get_item_count()const noexcept
+		{
+		if(m_level==0)
+			return ((_item_group_t const*)this)->get_item_count();
+		return ((_parent_group_t const*)this)->get_item_count();
+		}
+	inline uint16_t get_level()const noexcept { return m_level; }
+
+	// Sharing
+	// Groups are shared by persistent clusters and copied before modification.
+	inline bool acquire()noexcept
+		{
+		uint16_t refs=m_refs.load(std::memory_order_relaxed);
+		do
+			{
+			if(refs==UINT16_MAX)
+				return false;
+			}
+		while(!m_refs.compare_exchange_weak(refs, (uint16_t)(refs+1), std::memory_order_relaxed));
+		return true;
+		}
+	inline bool is_shared()const noexcept { return m_refs.load(std::memory_order_acquire)>1; }
+	inline bool release()noexcept
+		{
+		if(m_refs.load(std::memory_order_acquire)==1)
+			return true;
+		return m_refs.fetch_sub(1, std::memory_order_acq_rel)==1;
+		}
 
 	// Modification
-	virtual void remove_at(_size_t position, _item_t* item_ptr)=0;
+	void remove_at(_alloc_t& alloc, _size_t position, _item_t* item_ptr)
+		{
+		if(m_level==0)
+			{
+			((_item_group_t*)this)->remove_at(alloc, position, item_ptr);
+			return;
+			}
+		((_parent_group_t*)this)->remove_at(alloc, position, item_ptr);
+		}
+	void remove_range(_alloc_t& alloc, _size_t position, _size_t count)noexcept
+		{
+		if(m_level==0)
+			{
+			((_item_group_t*)this)->remove_items((uint16_t)position, (uint16_t)count);
+			return;
+			}
+		((_parent_group_t*)this)->remove_range(alloc, position, count);
+		}
+	void split_at(_alloc_t& alloc, _size_t position, _group_t* tail)
+		{
+		if(m_level==0)
+			{
+			auto item_group=(_item_group_t*)this;
+			auto tail_group=(_item_group_t*)tail;
+			uint16_t count=(uint16_t)(item_group->get_child_count()-position);
+			tail_group->insert_items(0, &item_group->get_items()[position], count);
+			item_group->remove_items((uint16_t)position, count);
+			return;
+			}
+		((_parent_group_t*)this)->split_at(alloc, position, (_parent_group_t*)tail);
+		}
+
+protected:
+	// Con-/Destructors
+	cluster_group(uint16_t level)noexcept: m_level(level), m_refs(1) {}
+
+	// Common
+	uint16_t m_level;
+	std::atomic<uint16_t> m_refs;
 };
 
 
@@ -72,6 +351,7 @@ class cluster_item_group: public _traits_t::group_t
 {
 public:
 	// Using
+	using _alloc_t=typename _traits_t::alloc_t;
 	using _item_t=typename _traits_t::item_t;
 	using _group_t=typename _traits_t::group_t;
 	using _item_group_t=typename _traits_t::item_group_t;
@@ -79,73 +359,85 @@ public:
 	static const uint16_t _group_size=_traits_t::group_size;
 
 	// Con-/Destructors
-	cluster_item_group()noexcept: m_item_count(0), m_items() {}
-	cluster_item_group(cluster_item_group const& group): m_item_count(group.m_item_count)
+	cluster_item_group()noexcept: _group_t(0), m_item_count(0), m_items() {}
+	cluster_item_group(cluster_item_group const& group): _group_t(0), m_item_count(group.m_item_count)
 		{
 		_item_t* items=get_items();
 		_item_t const* copy=group.get_items();
-		for(uint16_t u=0; u<m_item_count; u++)
-			new (&items[u]) _item_t(copy[u]);
+		if constexpr(std::is_trivially_copyable<_item_t>::value)
+			{
+			std::copy(copy, copy+m_item_count, items);
+			}
+		else
+			{
+			for(uint16_t u=0; u<m_item_count; u++)
+				new (&items[u]) _item_t(copy[u]);
+			}
 		}
 	~cluster_item_group()noexcept
 		{
-		auto items=get_items();
-		for(uint16_t u=0; u<m_item_count; u++)
-			items[u].~_item_t();
+		if constexpr(!std::is_trivially_destructible<_item_t>::value)
+			{
+			auto items=get_items();
+			for(uint16_t u=0; u<m_item_count; u++)
+				items[u].~_item_t();
+			}
 		}
 
 	// Access
-	_item_t& get_at(_size_t position)override
+	_item_t& get_at(_size_t position)
 		{
 		if(position>=m_item_count)
 			throw std::out_of_range(nullptr);
 		return get_items()[position];
 		}
-	_item_t const& get_at(_size_t position)const override
+	_item_t const& get_at(_size_t position)const
 		{
 		if(position>=m_item_count)
 			throw std::out_of_range(nullptr);
 		return get_items()[position];
 		}
-	inline uint16_t get_child_count()const noexcept override { return m_item_count; }
+	inline uint16_t get_child_count()const noexcept { return m_item_count; }
 	inline _item_t const& get_first_item()const noexcept { return get_items()[0]; }
-	inline _size_t get_item_count()const noexcept override { return m_item_count; }
+	inline _size_t get_item_count()const noexcept { return m_item_count; }
 	inline _item_t* get_items()noexcept { return (_item_t*)m_items; }
 	inline _item_t const* get_items()const noexcept { return (_item_t const*)m_items; }
 	inline _item_t const& get_last_item()const noexcept { return get_items()[m_item_count-1]; }
-	inline uint16_t get_level()const noexcept override { return 0; }
 
 	// Modification
-	_item_t* insert_item(uint16_t position, _item_t const& insert)
-		{
-		if(m_item_count+1>_group_size)
-			return nullptr;
-		_item_t* items=get_items();
-		for(uint16_t u=m_item_count; u>=position+1; u--)
-			new (&items[u]) _item_t(std::move(items[u-1]));
-		new (&items[position]) _item_t(insert);
-		m_item_count++;
-		return &items[position];
-		}
-	_item_t* insert_item(uint16_t position, _item_t&& insert)noexcept
+	template <class... _args_t> _item_t* emplace_item(uint16_t position, _args_t&&... args)
 		{
 		if(m_item_count+1>_group_size)
 			return nullptr;
 		_item_t* items=get_items();
-		for(uint16_t u=m_item_count; u>=position+1; u--)
-			new (&items[u]) _item_t(std::move(items[u-1]));
-		new (&items[position]) _item_t(std::move(insert));
+		move_items(&items[position+1], &items[position], (uint16_t)(m_item_count-position));
+		try
+			{
+			new (&items[position]) _item_t(std::forward<_args_t>(args)...);
+			}
+		catch(...)
+			{
+			move_items(&items[position], &items[position+1], (uint16_t)(m_item_count-position));
+			throw;
+			}
 		m_item_count++;
 		return &items[position];
 		}
+	inline _item_t* insert_item(uint16_t position, _item_t const& insert) { return emplace_item(position, insert); }
+	inline _item_t* insert_item(uint16_t position, _item_t&& insert)noexcept { return emplace_item(position, std::move(insert)); }
 	uint16_t insert_items(uint16_t position, _item_t* insert, uint16_t count)noexcept
 		{
 		_item_t* items=get_items();
-		uint16_t u=(uint16_t)(m_item_count+count-1);
-		for(; u>=position+count; u--)
-			new (&items[u]) _item_t(std::move(items[u-count]));
-		for(u=0; u<count; u++)
-			new (&items[position+u]) _item_t(std::move(insert[u]));
+		move_items(&items[position+count], &items[position], (uint16_t)(m_item_count-position));
+		if constexpr(std::is_trivially_copyable<_item_t>::value)
+			{
+			std::copy(insert, insert+count, &items[position]);
+			}
+		else
+			{
+			for(uint16_t u=0; u<count; u++)
+				new (&items[position+u]) _item_t(std::move(insert[u]));
+			}
 		m_item_count+=count;
 		return count;
 		}
@@ -157,15 +449,20 @@ public:
 		if(copy>_group_size-m_item_count)
 			copy=_group_size-m_item_count;
 		_item_t* items=get_items();
-		uint16_t u=(uint16_t)(m_item_count+copy-1);
-		for(; u>=position+copy; u--)
-			new (&items[u]) _item_t(std::move(items[u-copy]));
-		for(u=0; u<copy; u++)
-			new (&items[position+u]) _item_t(insert[u]);
+		move_items(&items[position+copy], &items[position], (uint16_t)(m_item_count-position));
+		if constexpr(std::is_trivially_copyable<_item_t>::value)
+			{
+			std::copy(insert, insert+copy, &items[position]);
+			}
+		else
+			{
+			for(uint16_t u=0; u<copy; u++)
+				new (&items[position+u]) _item_t(insert[u]);
+			}
 		m_item_count+=copy;
 		return copy;
 		}
-	void remove_at(_size_t position, _item_t* item_ptr)override
+	void remove_at(_alloc_t&, _size_t position, _item_t* item_ptr)
 		{
 		if(position>=m_item_count)
 			throw std::out_of_range(nullptr);
@@ -175,12 +472,8 @@ public:
 			item_ptr->~_item_t();
 			new (item_ptr) _item_t(std::move(items[position]));
 			}
-		else
-			{
-			items[position].~_item_t();
-			}
-		for(uint16_t u=(uint16_t)position; u+1<m_item_count; u++)
-			new (&items[u]) _item_t(std::move(items[u+1]));
+		items[position].~_item_t();
+		move_items(&items[position], &items[position+1], (uint16_t)(m_item_count-position-1));
 		m_item_count--;
 		}
 	void remove_items(uint16_t position, uint16_t count)noexcept
@@ -188,16 +481,44 @@ public:
 		_item_t* items=get_items();
 		for(uint16_t u=0; u<count; u++)
 			items[position+u].~_item_t();
-		for(; position+count<m_item_count; position++)
-			{
-			items[position].~_item_t();
-			new (&items[position]) _item_t(std::move(items[position+count]));
-			}
+		move_items(&items[position], &items[position+count], (uint16_t)(m_item_count-position-count));
 		m_item_count-=count;
 		}
 
 protected:
 	// Common
+	static void move_items(_item_t* dst, _item_t* src, uint16_t count)noexcept
+		{
+		if(count==0||dst==src)
+			return;
+		if constexpr(std::is_trivially_copyable<_item_t>::value)
+			{
+			if(dst<src)
+				{
+				std::copy(src, src+count, dst);
+				}
+			else
+				{
+				std::copy_backward(src, src+count, dst+count);
+				}
+			}
+		else if(dst<src)
+			{
+			for(uint16_t u=0; u<count; u++)
+				{
+				new (&dst[u]) _item_t(std::move(src[u]));
+				src[u].~_item_t();
+				}
+			}
+		else
+			{
+			for(uint16_t u=count; u>0; u--)
+				{
+				new (&dst[u-1]) _item_t(std::move(src[u-1]));
+				src[u-1].~_item_t();
+				}
+			}
+		}
 	uint16_t m_item_count;
 
 private:
@@ -215,6 +536,8 @@ class cluster_parent_group: public _traits_t::group_t
 {
 public:
 	// Using
+	using _alloc_t=typename _traits_t::alloc_t;
+	using _allocator_t=cluster_allocator<_traits_t>;
 	using _item_t=typename _traits_t::item_t;
 	using _group_t=typename _traits_t::group_t;
 	using _item_group_t=typename _traits_t::item_group_t;
@@ -224,93 +547,179 @@ public:
 
 	// Con-/Destructors
 	cluster_parent_group(uint16_t level=1)noexcept:
-		m_child_count(0), m_children(), m_item_count(0), m_level(level)
+		_group_t(level), m_child_count(0), m_shared(false), m_children(), m_item_counts()
 		{}
-	cluster_parent_group(cluster_parent_group const& group):
-		m_child_count(group.m_child_count), m_children(), m_item_count(group.m_item_count), m_level(group.m_level)
+	cluster_parent_group(_alloc_t& alloc, cluster_parent_group const& group):
+		_group_t(group.m_level), m_child_count(group.m_child_count), m_shared(false), m_children(), m_item_counts()
 		{
-		if(m_level>1)
-			{
-			for(uint16_t u=0; u<m_child_count; u++)
-				m_children[u]=new _parent_group_t((_parent_group_t const&)*group.m_children[u]);
-			}
-		else
+		for(uint16_t u=0; u<m_child_count; u++)
 			{
-			for(uint16_t u=0; u<m_child_count; u++)
-				m_children[u]=new _item_group_t((_item_group_t const&)*group.m_children[u]);
+			m_children[u]=_allocator_t::copy_group(alloc, group.m_children[u]);
+			m_item_counts[u]=group.m_item_counts[u];
 			}
 		}
-	~cluster_parent_group()noexcept override
-		{
-		for(uint16_t u=0; u<m_child_count; u++)
-			delete m_children[u];
-		}
 
 	// Access
-	_item_t& get_at(_size_t position)override
+	template <class _func_t> bool for_each_chunk(_size_t position, _size_t count, _func_t& func)
 		{
-		if(position>=m_item_count)
+		uint16_t group=get_group(&position);
+		for(; count>0; group++)
+			{
+			_size_t chunk=m_item_counts[group]-get_offset(group)-position;
+			if(chunk>count)
+				chunk=count;
+			if(!m_children[group]->for_each_chunk(position, chunk, func))
+				return false;
+			count-=chunk;
+			position=0;
+			}
+		return true;
+		}
+	_item_t& get_at(_size_t position)
+		{
+		if(position>=get_item_count())
 			throw std::out_of_range(nullptr);
 		uint16_t group=get_group(&position);
 		return m_children[group]->get_at(position);
 		}
-	_item_t const& get_at(_size_t position)const override
+	_item_t const& get_at(_size_t position)const
 		{
-		if(position>=m_item_count)
+		if(position>=get_item_count())
 			throw std::out_of_range(nullptr);
 		uint16_t group=get_group(&position);
 		return m_children[group]->get_at(position);
 		}
 	inline _group_t* get_child(uint16_t position)const noexcept { return m_children[position]; }
-	inline uint16_t get_child_count()const noexcept override { return m_child_count; }
+	inline uint16_t get_child_count()const noexcept { return m_child_count; }
 	inline _group_t* const* get_children()const noexcept { return m_children; }
 	uint16_t get_group(_size_t* position)const noexcept
 		{
-		for(uint16_t u=0; u<m_child_count; u++)
+		uint16_t start=0;
+		uint16_t end=m_child_count;
+		while(start<end)
 			{
-			_size_t count=m_children[u]->get_item_count();
-			if(*position<count)
-				return u;
-			*position-=count;
+			uint16_t u=(uint16_t)(start+(end-start)/2);
+			if(m_item_counts[u]>*position)
+				{
+				end=u;
+				}
+			else
+				{
+				start=(uint16_t)(u+1);
+				}
 			}
-		return _group_size;
+		if(start==m_child_count)
+			return _group_size;
+		*position-=get_offset(start);
+		return start;
 		}
-	inline _size_t get_item_count()const noexcept override { return m_item_count; }
-	inline uint16_t get_level()const noexcept override { return m_level; }
+	inline _size_t get_item_count()const noexcept { return m_child_count? m_item_counts[m_child_count-1]: 0; }
+	inline _size_t get_offset(uint16_t position)const noexcept { return position? m_item_counts[position-1]: 0; }
 
 	// Modification
-	virtual _size_t insert_groups(uint16_t position, _group_t* const* groups, uint16_t count)noexcept
+	_parent_group_t* append_group(_alloc_t& alloc, _group_t* group)
+		{
+		unshare_children(alloc);
+		_parent_group_t* spare=nullptr;
+		if(m_child_count==_group_size)
+			spare=_allocator_t::template create<_parent_group_t>(alloc, this->m_level);
+		if(this->m_level>group->get_level()+1)
+			{
+			uint16_t last=(uint16_t)(m_child_count-1);
+			auto child=(_parent_group_t*)m_children[last];
+			_size_t item_count=child->get_item_count();
+			try
+				{
+				group=child->append_group(alloc, group);
+				}
+			catch(...)
+				{
+				if(spare)
+					_allocator_t::free_group(alloc, spare);
+				throw;
+				}
+			inc_item_count(last, child->get_item_count()-item_count);
+			if(!group)
+				{
+				if(spare)
+					_allocator_t::free_group(alloc, spare);
+				return nullptr;
+				}
+			}
+		if(!spare)
+			{
+			insert_groups(m_child_count, &group, 1);
+			return nullptr;
+			}
+		spare->insert_groups(0, &group, 1);
+		return spare;
+		}
+	void balance_path(_alloc_t& alloc, _size_t position)
 		{
+		// The children along the path are combined with their neighbours or filled up from them,
+		// before and after their own children have been balanced.
+		unshare_children(alloc);
+		_size_t pos=position;
+		uint16_t group=get_group(&pos);
+		if(balance_child(alloc, group))
+			{
+			pos=position;
+			group=get_group(&pos);
+			}
+		if(this->m_level>1)
+			{
+			((_parent_group_t*)m_children[group])->balance_path(alloc, pos);
+			pos=position;
+			group=get_group(&pos);
+			balance_child(alloc, group);
+			}
+		((_parent_group_t*)this)->update_bounds();
+		}
+	_size_t insert_groups(uint16_t position, _group_t* const* groups, uint16_t count)noexcept
+		{
+		_size_t item_count=0;
+		for(uint16_t u=0; u<count; u++)
+			{
+			item_count+=groups[u]->get_item_count();
+			if(groups[u]->is_shared())
+				m_shared.store(true, std::memory_order_relaxed);
+			}
 		for(uint16_t u=(uint16_t)(m_child_count+count-1); u>=position+count; u--)
+			{
 			m_children[u]=m_children[u-count];
-		_size_t item_count=0;
+			m_item_counts[u]=m_item_counts[u-count]+item_count;
+			}
+		_size_t offset=get_offset(position);
 		for(uint16_t u=0; u<count; u++)
 			{
 			m_children[position+u]=groups[u];
-			item_count+=groups[u]->get_item_count();
+			offset+=groups[u]->get_item_count();
+			m_item_counts[position+u]=offset;
 			}
 		m_child_count=(uint16_t)(m_child_count+count);
-		m_item_count+=item_count;
 		return item_count;
 		}
 	void move_children(uint16_t source, uint16_t destination, uint16_t count)noexcept
 		{
-		if(m_level>1)
+		_size_t item_count=count;
+		if(this->m_level>1)
 			{
 			auto src=(_parent_group_t*)m_children[source];
 			auto dst=(_parent_group_t*)m_children[destination];
 			auto src_groups=src->get_children();
+			if(src->m_shared.load(std::memory_order_relaxed))
+				dst->m_shared.store(true, std::memory_order_relaxed);
 			if(source>destination)
 				{
 				uint16_t dst_count=dst->get_child_count();
-				auto item_count=dst->insert_groups(dst_count, src_groups, count);
+				item_count=dst->insert_groups(dst_count, src_groups, count);
 				src->remove_groups(0, count, item_count);
 				}
 			else
 				{
 				uint16_t src_count=src->get_child_count();
 				uint16_t src_pos=(uint16_t)(src_count-count);
-				auto item_count=dst->insert_groups(0, &src_groups[src_pos], count);
+				item_count=dst->insert_groups(0, &src_groups[src_pos], count);
 				src->remove_groups(src_pos, count, item_count);
 				}
 			}
@@ -333,6 +742,16 @@ public:
 				src->remove_items(src_pos, count);
 				}
 			}
+		if(source>destination)
+			{
+			for(uint16_t u=destination; u<source; u++)
+				m_item_counts[u]+=item_count;
+			}
+		else
+			{
+			for(uint16_t u=source; u<destination; u++)
+				m_item_counts[u]-=item_count;
+			}
 		}
 	void move_emtpy_slot(uint16_t source, uint16_t destination)noexcept
 		{
@@ -347,30 +766,184 @@ public:
 				move_children((uint16_t)(u-1), u, 1);
 			}
 		}
-	virtual void remove_at(_size_t position, _item_t* item_ptr)override
+	_parent_group_t* prepend_group(_alloc_t& alloc, _group_t* group)
 		{
-		if(position>=m_item_count)
+		unshare_children(alloc);
+		_parent_group_t* spare=nullptr;
+		if(m_child_count==_group_size)
+			spare=_allocator_t::template create<_parent_group_t>(alloc, this->m_level);
+		if(this->m_level>group->get_level()+1)
+			{
+			auto child=(_parent_group_t*)m_children[0];
+			_size_t item_count=child->get_item_count();
+			try
+				{
+				group=child->prepend_group(alloc, group);
+				}
+			catch(...)
+				{
+				if(spare)
+					_allocator_t::free_group(alloc, spare);
+				throw;
+				}
+			inc_item_count(0, child->get_item_count()-item_count);
+			if(!group)
+				{
+				if(spare)
+					_allocator_t::free_group(alloc, spare);
+				return nullptr;
+				}
+			}
+		if(!spare)
+			{
+			insert_groups(0, &group, 1);
+			return nullptr;
+			}
+		spare->insert_groups(0, &group, 1);
+		return spare;
+		}
+	void remove_at(_alloc_t& alloc, _size_t position, _item_t* item_ptr)
+		{
+		if(position>=get_item_count())
 			throw std::out_of_range(nullptr);
+		unshare_children(alloc);
 		uint16_t group=get_group(&position);
-		m_children[group]->remove_at(position, item_ptr);
-		m_item_count--;
-		combine_children(group);
+		m_children[group]->remove_at(alloc, position, item_ptr);
+		dec_item_count(group);
+		combine_children(alloc, group);
 		}
-	virtual void remove_groups(uint16_t position, uint16_t count, _size_t item_count)noexcept
+	void remove_groups(uint16_t position, uint16_t count, _size_t item_count)noexcept
 		{
 		for(uint16_t u=position; u+count<m_child_count; u++)
+			{
 			m_children[u]=m_children[u+count];
+			m_item_counts[u]=m_item_counts[u+count]-item_count;
+			}
 		m_child_count-=count;
-		m_item_count-=item_count;
 		}
-	virtual void set_child(_group_t* child)noexcept
+	void remove_range(_alloc_t& alloc, _size_t position, _size_t count)noexcept
+		{
+		_size_t first_pos=position;
+		uint16_t first=get_group(&first_pos);
+		_size_t last_pos=position+count-1;
+		uint16_t last=get_group(&last_pos);
+		if(first==last&&count<m_children[first]->get_item_count())
+			{
+			m_children[first]->remove_range(alloc, first_pos, count);
+			dec_item_count(first, count);
+			combine_children(alloc, first);
+			return;
+			}
+		// Children in between are dropped as a whole.
+		uint16_t start=first;
+		uint16_t end=(uint16_t)(last+1);
+		if(first_pos>0)
+			{
+			_size_t remove=m_children[first]->get_item_count()-first_pos;
+			m_children[first]->remove_range(alloc, first_pos, remove);
+			dec_item_count(first, remove);
+			start++;
+			}
+		if(last_pos+1<m_children[last]->get_item_count())
+			{
+			m_children[last]->remove_range(alloc, 0, last_pos+1);
+			dec_item_count(last, last_pos+1);
+			end--;
+			}
+		_size_t item_count=0;
+		for(uint16_t u=start; u<end; u++)
+			{
+			item_count+=m_children[u]->get_item_count();
+			_allocator_t::free_group(alloc, m_children[u]);
+			}
+		remove_groups(start, (uint16_t)(end-start), item_count);
+		// Boundary-children are combined with their neighbours.
+		if(end<=last&&start<m_child_count)
+			combine_children(alloc, start);
+		if(start>first)
+			combine_children(alloc, first);
+		}
+	void set_child(_group_t* child)noexcept
 		{
+		if(child->is_shared())
+			m_shared.store(true, std::memory_order_relaxed);
 		m_children[0]=child;
 		m_child_count=1;
-		m_item_count=child->get_item_count();
-		m_level=child->get_level()+1;
+		m_item_counts[0]=child->get_item_count();
+		this->m_level=(uint16_t)(child->get_level()+1);
 		}
 	inline void set_child_count(uint16_t count)noexcept { m_child_count=count; }
+	void split_at(_alloc_t& alloc, _size_t position, _parent_group_t* tail)
+		{
+		unshare_children(alloc);
+		uint16_t group=get_group(&position);
+		uint16_t first=group;
+		if(position>0)
+			{
+			auto child=m_children[group];
+			auto child_tail=_allocator_t::create_group(alloc, child->get_level());
+			try
+				{
+				child->split_at(alloc, position, child_tail);
+				}
+			catch(...)
+				{
+				_allocator_t::free_group(alloc, child_tail);
+				throw;
+				}
+			m_item_counts[group]=get_offset(group)+child->get_item_count();
+			tail->insert_groups(0, &child_tail, 1);
+			first++;
+			}
+		tail->insert_groups(tail->get_child_count(), &m_children[first], (uint16_t)(m_child_count-first));
+		m_child_count=first;
+		// Boundary-children are combined with their neighbours.
+		combine_children(alloc, (uint16_t)(first-1));
+		tail->combine_children(alloc, 0);
+		}
+	inline void set_shared()const noexcept { m_shared.store(true, std::memory_order_relaxed); }
+	void unshare(_alloc_t& alloc, _size_t first, _size_t last)
+		{
+		unshare_children(alloc);
+		if(this->m_level==1)
+			return;
+		uint16_t group=get_group(&first);
+		uint16_t last_group=get_group(&last);
+		for(uint16_t u=group; u<=last_group; u++)
+			{
+			_size_t child_first=(u==group)? first: 0;
+			_size_t child_last=(u==last_group)? last: m_children[u]->get_item_count()-1;
+			((_parent_group_t*)m_children[u])->unshare(alloc, child_first, child_last);
+			}
+		}
+	void unshare_children(_alloc_t& alloc)
+		{
+		// All children are copied, they can be modified by their siblings.
+		if(!m_shared.load(std::memory_order_relaxed))
+			return;
+		try
+			{
+			for(uint16_t u=0; u<m_child_count; u++)
+				m_children[u]=_allocator_t::unshare_group(alloc, m_children[u]);
+			}
+		catch(...)
+			{
+			((_parent_group_t*)this)->update_bounds();
+			throw;
+			}
+		m_shared.store(false, std::memory_order_relaxed);
+		((_parent_group_t*)this)->update_bounds();
+		}
+	inline void update_bounds()noexcept {}
+	void update_item_counts()noexcept
+		{
+		_size_t item_count=0;
+		for(uint16_t u=0; u<m_child_count; u++)
+			{
+			item_count+=m_children[u]->get_item_count();
+			m_item_counts[u]=item_count;
+			}
+		}
 
 protected:
 	// Access
@@ -397,12 +970,32 @@ protected:
 		}
 
 	// Modification
-	bool combine_children(uint16_t position)noexcept
+	bool balance_child(_alloc_t& alloc, uint16_t position)noexcept
+		{
+		if(m_child_count<2)
+			return false;
+		if(combine_children(alloc, position))
+			return true;
+		uint16_t count=m_children[position]->get_child_count();
+		if(count>=_group_size/2)
+			return false;
+		// Underfull children take over children from their bigger neighbour.
+		uint16_t neighbour=(uint16_t)(position>0? position-1: position+1);
+		if(position>0&&position+1<m_child_count)
+			{
+			if(m_children[position+1]->get_child_count()>m_children[neighbour]->get_child_count())
+				neighbour=(uint16_t)(position+1);
+			}
+		uint16_t move=(uint16_t)((m_children[neighbour]->get_child_count()-count)/2);
+		move_children(neighbour, position, move);
+		return true;
+		}
+	bool combine_children(_alloc_t& alloc, uint16_t position)noexcept
 		{
 		uint16_t count=m_children[position]->get_child_count();
 		if(count==0)
 			{
-			remove_group(position);
+			remove_group(alloc, position);
 			return true;
 			}
 		if(position>0)
@@ -411,7 +1004,7 @@ protected:
 			if(count+before<=_group_size)
 				{
 				move_children(position, (uint16_t)(position-1), count);
-				remove_group(position);
+				remove_group(alloc, position);
 				return true;
 				}
 			}
@@ -421,17 +1014,31 @@ protected:
 			if(count+after<=_group_size)
 				{
 				move_children((uint16_t)(position+1), position, after);
-				remove_group((uint16_t)(position+1));
+				remove_group(alloc, (uint16_t)(position+1));
 				return true;
 				}
 			}
 		return false;
 		}
-	void remove_group(uint16_t position)noexcept
+	void dec_item_count(uint16_t position, _size_t count=1)noexcept
+		{
+		for(uint16_t u=position; u<m_child_count; u++)
+			m_item_counts[u]-=count;
+		}
+	void inc_item_count(uint16_t position, _size_t count=1)noexcept
 		{
-		delete m_children[position];
+		for(uint16_t u=position; u<m_child_count; u++)
+			m_item_counts[u]+=count;
+		}
+	void remove_group(_alloc_t& alloc, uint16_t position)noexcept
+		{
+		_size_t item_count=m_children[position]->get_item_count();
+		_allocator_t::free_group(alloc, m_children[position]);
 		for(uint16_t u=position; u+1<m_child_count; u++)
+			{
 			m_children[u]=m_children[u+1];
+			m_item_counts[u]=m_item_counts[u+1]-item_count;
+			}
 		m_child_count--;
 		}
 	bool shift_children(uint16_t group, uint16_t ins_count)noexcept
@@ -444,20 +1051,18 @@ protected:
 		move_emtpy_slot(empty, group);
 		return true;
 		}
-	bool split_child(uint16_t position)
+	bool split_child(_alloc_t& alloc, uint16_t position)
 		{
 		if(m_child_count==_group_size)
 			return false;
+		auto group=_allocator_t::create_group(alloc, (uint16_t)(this->m_level-1));
 		for(uint16_t u=m_child_count; u>position+1; u--)
-			m_children[u]=m_children[u-1];
-		if(m_level>1)
-			{
-			m_children[position+1]=new _parent_group_t((uint16_t)(m_level-1));
-			}
-		else
 			{
-			m_children[position+1]=new _item_group_t();
+			m_children[u]=m_children[u-1];
+			m_item_counts[u]=m_item_counts[u-1];
 			}
+		m_children[position+1]=group;
+		m_item_counts[position+1]=m_item_counts[position];
 		m_child_count++;
 		move_children(position, (uint16_t)(position+1), 1);
 		return true;
@@ -465,9 +1070,9 @@ protected:
 	
 	// Common
 	uint16_t m_child_count;
+	mutable std::atomic<bool> m_shared;
 	_group_t* m_children[_group_size];
-	_size_t m_item_count;
-	uint16_t m_level;
+	_size_t m_item_counts[_group_size];
 };
 
 
@@ -480,6 +1085,8 @@ class cluster
 {
 public:
 	// Using
+	using _alloc_t=typename _traits_t::alloc_t;
+	using _allocator_t=cluster_allocator<_traits_t>;
 	using _item_t=typename _traits_t::item_t;
 	using _group_t=typename _traits_t::group_t;
 	using _item_group_t=typename _traits_t::item_group_t;
@@ -507,10 +1114,24 @@ public:
 	inline const_iterator crend()const { return const_iterator(this, -1); }
 	inline iterator end() { return iterator(this, -2); }
 	inline const_iterator end()const { return const_iterator(this, -2); }
+	template <class _func_t> inline bool for_each_chunk(_func_t&& func) { return for_each_chunk(0, get_count(), std::forward<_func_t>(func)); }
+	template <class _func_t> inline bool for_each_chunk(_func_t&& func)const { return for_each_chunk(0, get_count(), std::forward<_func_t>(func)); }
+	template <class _func_t> bool for_each_chunk(_size_t position, _size_t count, _func_t&& func)
+		{
+		if(count>0)
+			unshare(position, position+count-1);
+		return for_each_chunk_internal<_item_t*>(position, count, func);
+		}
+	template <class _func_t> bool for_each_chunk(_size_t position, _size_t count, _func_t&& func)const
+		{
+		return const_cast<cluster*>(this)->template for_each_chunk_internal<_item_t const*>(position, count, func);
+		}
+	inline _alloc_t& get_allocator()noexcept { return m_alloc; }
 	_item_t& get_at(_size_t position)
 		{
 		if(!m_root)
 			throw std::out_of_range(nullptr);
+		unshare(position, position);
 		return m_root->get_at(position);
 		}
 	_item_t const& get_at(_size_t position)const
@@ -526,6 +1147,65 @@ public:
 		return m_root->get_item_count();
 		}
 	inline _group_t* get_root()const noexcept { return m_root; }
+	template <class _func_t> void parallel_for_each(_func_t&& func, unsigned int thread_count=0)
+		{
+		// Shared groups are copied by the blocks one after another, the root is copied before.
+		bool shared=m_shared;
+		if(shared)
+			unshare_root();
+		std::mutex mutex;
+		auto block=[this, shared, &func, &mutex](_size_t, _size_t position, _size_t count)
+			{
+			if(shared&&m_root->get_level()>0)
+				{
+				std::lock_guard<std::mutex> lock(mutex);
+				((_parent_group_t*)m_root)->unshare(m_alloc, position, position+count-1);
+				}
+			auto chunk=[&func](_item_t* items, uint16_t chunk_count)
+				{
+				for(uint16_t u=0; u<chunk_count; u++)
+					func(items[u]);
+				};
+			for_each_chunk_internal<_item_t*>(position, count, chunk);
+			};
+		cluster_parallel::run(get_count(), thread_count, block);
+		m_shared=false;
+		}
+	template <class _func_t> void parallel_for_each(_func_t&& func, unsigned int thread_count=0)const
+		{
+		auto block=[this, &func](_size_t, _size_t position, _size_t count)
+			{
+			for_each_chunk(position, count, [&func](_item_t const* items, uint16_t chunk_count)
+				{
+				for(uint16_t u=0; u<chunk_count; u++)
+					func(items[u]);
+				});
+			};
+		cluster_parallel::run(get_count(), thread_count, block);
+		}
+	template <class _value_t, class _map_t, class _combine_t> _value_t parallel_reduce(_value_t const& identity, _map_t&& map, _combine_t&& combine, unsigned int thread_count=0)const
+		{
+		// Blocks are reduced separately and combined in order,
+		// so the result doesn't depend on the number of threads.
+		struct value_t { _value_t value; };
+		_size_t count=get_count();
+		std::vector<value_t> values(cluster_parallel::get_block_count(count), value_t{ identity });
+		auto block=[this, &map, &combine, &values](_size_t block, _size_t position, _size_t count)
+			{
+			_value_t& value=values[block].value;
+			for_each_chunk(position, count, [&](_item_t const* items, uint16_t chunk_count)
+				{
+				for(uint16_t u=0; u<chunk_count; u++)
+					value=combine(std::move(value), map(items[u]));
+				});
+			};
+		cluster_parallel::run(count, thread_count, block);
+		_value_t value=identity;
+		for(auto& block_value: values)
+			value=combine(std::move(value), std::move(block_value.value));
+		return value;
+		}
+	inline bool is_persistent()const noexcept { return m_persistent; }
 	inline iterator rend() { return iterator(this, -1); }
 
 	// Modification
@@ -533,81 +1213,426 @@ public:
 		{
 		if(m_root)
 			{
-			delete m_root;
+			_allocator_t::free_group(m_alloc, m_root);
 			m_root=nullptr;
+			m_shared=false;
 			return true;
 			}
 		return false;
 		}
 	void copy_from(_cluster_t const& cluster)
 		{
-		clear();
-		auto root=cluster.get_root();
-		if(!root)
+		if(this==&cluster)
 			return;
-		auto level=root->get_level();
-		if(level>0)
-			{
-			auto parent_group=(_parent_group_t const*)root;
-			m_root=new _parent_group_t(*parent_group);
-			}
-		else
+		clear();
+		bool shared=false;
+		m_root=copy_root(m_alloc, cluster, &shared);
+		if(shared)
 			{
-			auto item_group=(_item_group_t const*)root;
-			m_root=new _item_group_t(*item_group);
+			m_persistent=true;
+			m_shared=true;
 			}
 		}
 	void remove_at(_size_t position, _item_t* item_ptr=nullptr)
 		{
 		if(!m_root)
 			throw std::out_of_range(nullptr);
-		m_root->remove_at(position, item_ptr);
+		unshare_root();
+		m_root->remove_at(m_alloc, position, item_ptr);
 		drop_root();
 		}
+	void remove_range(_size_t position, _size_t count)
+		{
+		_size_t item_count=get_count();
+		if(position>item_count||count>item_count-position)
+			throw std::out_of_range(nullptr);
+		if(count==0)
+			return;
+		if(count==item_count)
+			{
+			clear();
+			return;
+			}
+		// Only the boundaries are modified, removed groups are released.
+		unshare(position>0? position-1: 0, position);
+		unshare(position+count-1, position+count);
+		m_root->remove_range(m_alloc, position, count);
+		while(m_root->get_level()>0&&m_root->get_child_count()==1)
+			{
+			if(!drop_root())
+				break;
+			}
+		}
+	inline void set_persistent(bool persistent)noexcept { m_persistent=persistent; }
+	_cluster_t split_at(_size_t position)
+		{
+		_cluster_t tail(m_alloc);
+		split_to(tail, position);
+		return tail;
+		}
 
 protected:
 	// Con-/Destructors
-	cluster(_group_t* root)noexcept: m_root(root) {}
+	cluster(_group_t* root)noexcept: m_alloc(), m_root(root), m_persistent(false), m_shared(false) {}
+	cluster(_group_t* root, _alloc_t const& alloc): m_alloc(alloc), m_root(root), m_persistent(false), m_shared(false) {}
+	cluster(cluster&& cluster)noexcept:
+		m_alloc(std::move(cluster.m_alloc)), m_root(cluster.m_root), m_persistent(cluster.m_persistent), m_shared(cluster.m_shared.load())
+		{
+		cluster.m_root=nullptr;
+		cluster.m_shared=false;
+		}
 	~cluster()noexcept
 		{
 		if(m_root)
 			{
-			delete m_root;
+			_allocator_t::free_group(m_alloc, m_root);
 			m_root=nullptr;
 			}
 		}
 
 	// Common
+	void balance_root(_size_t position)
+		{
+		// Groups along the path to the position are balanced, roots with a single child are dropped.
+		unshare_root();
+		if(m_root->get_level()>0)
+			((_parent_group_t*)m_root)->balance_path(m_alloc, position);
+		while(m_root->get_level()>0&&m_root->get_child_count()==1)
+			{
+			if(!drop_root())
+				break;
+			}
+		}
+	void concat_from(cluster& tail)
+		{
+		// Empty roots are freed, they are never grafted.
+		if(tail.get_count()==0)
+			{
+			tail.clear();
+			return;
+			}
+		_size_t count=get_count();
+		if(count==0)
+			clear();
+		auto group=tail.m_root;
+		unshare_root();
+		tail.unshare_root();
+		group=tail.m_root;
+		// Groups of other allocators are copied.
+		bool copied=false;
+		if(m_alloc!=tail.m_alloc)
+			{
+			group=_allocator_t::copy_group(m_alloc, group);
+			copied=true;
+			}
+		_parent_group_t* root=nullptr;
+		try
+			{
+			if(m_root)
+				group=graft_group(group, &root);
+			}
+		catch(...)
+			{
+			if(copied)
+				_allocator_t::free_group(m_alloc, group);
+			throw;
+			}
+		if(copied)
+			{
+			tail.clear();
+			}
+		else
+			{
+			tail.m_root=nullptr;
+			if(tail.m_shared)
+				m_shared=true;
+			tail.m_shared=false;
+			}
+		if(!m_root)
+			{
+			m_root=group;
+			return;
+			}
+		if(group)
+			{
+			_group_t* children[2]={ m_root, group };
+			root->insert_groups(0, children, 2);
+			m_root=root;
+			}
+		else
+			{
+			_allocator_t::free_group(m_alloc, root);
+			}
+		// Both sides of the seam are balanced.
+		balance_root(count-1);
+		balance_root(count);
+		}
+	static _group_t* copy_root(_alloc_t& alloc, cluster const& cluster, bool* shared_ptr)
+		{
+		auto root=cluster.m_root;
+		if(!root)
+			return nullptr;
+		// Groups of persistent clusters are shared if the allocators are exchangeable.
+		if(cluster.m_persistent&&alloc==cluster.m_alloc)
+			{
+			root=_allocator_t::share_group(alloc, root);
+			cluster.m_shared=true;
+			*shared_ptr=true;
+			return root;
+			}
+		return _allocator_t::copy_tree(alloc, root);
+		}
+	void share_to(cluster& copy)const
+		{
+		// All groups are shared with the copy, both sides copy the paths they modify.
+		copy.clear();
+		if(!m_root)
+			return;
+		copy.m_root=_allocator_t::share_group(copy.m_alloc, m_root);
+		copy.m_persistent=true;
+		copy.m_shared=true;
+		m_shared=true;
+		}
 	_group_t* create_root()
 		{
 		if(m_root)
 			return m_root;
-		m_root=new _item_group_t();
+		m_root=_allocator_t::template create<_item_group_t>(m_alloc);
 		return m_root;
 		}
-	void drop_root()noexcept
+	bool drop_root()noexcept
 		{
-		if(m_root->get_level()==0)
+		if(m_root->get_child_count()==0)
 			{
-			if(m_root->get_child_count()==0)
-				clear();
-			return;
+			clear();
+			return true;
 			}
+		if(m_root->get_level()==0)
+			return false;
 		if(m_root->get_child_count()>1)
-			return;
+			return false;
 		auto root=(_parent_group_t*)m_root;
-		m_root=root->get_child(0);
+		auto child=root->get_child(0);
+		if(root->is_shared())
+			{
+			// Shared roots are released, their child gets another reference.
+			if(!child->acquire())
+				return false;
+			m_root=child;
+			_allocator_t::free_group(m_alloc, root);
+			return true;
+			}
+		m_root=child;
 		root->set_child_count(0);
-		delete root;
+		_allocator_t::free_group(m_alloc, root);
+		return true;
 		}
 	_group_t* lift_root()
 		{
-		auto root=new _parent_group_t();
+		auto root=_allocator_t::template create<_parent_group_t>(m_alloc);
 		root->set_child(m_root);
 		m_root=root;
 		return m_root;
 		}
+	void split_to(cluster& tail, _size_t position)
+		{
+		_size_t count=get_count();
+		if(position>count)
+			throw std::out_of_range(nullptr);
+		tail.clear();
+		tail.m_persistent=m_persistent;
+		if(position==count)
+			return;
+		tail.m_shared=m_shared.load();
+		if(position==0)
+			{
+			tail.m_root=m_root;
+			m_root=nullptr;
+			m_shared=false;
+			return;
+			}
+		unshare_root();
+		auto tail_root=_allocator_t::create_group(m_alloc, m_root->get_level());
+		try
+			{
+			m_root->split_at(m_alloc, position, tail_root);
+			}
+		catch(...)
+			{
+			_allocator_t::free_group(m_alloc, tail_root);
+			throw;
+			}
+		tail.m_root=tail_root;
+		balance_root(position-1);
+		tail.balance_root(0);
+		}
+	void unshare(_size_t first, _size_t last)
+		{
+		// Shared groups are copied along the paths to the positions before modification,
+		// groups changing their structure copy their children themselves.
+		if(!m_shared||!m_root)
+			return;
+		_size_t count=m_root->get_item_count();
+		if(count==0)
+			return;
+		if(last>=count)
+			last=count-1;
+		if(first>last)
+			first=last;
+		m_root=_allocator_t::unshare_group(m_alloc, m_root);
+		if(m_root->get_level()>0)
+			((_parent_group_t*)m_root)->unshare(m_alloc, first, last);
+		}
+	inline void unshare_root()
+		{
+		if(m_shared&&m_root)
+			m_root=_allocator_t::unshare_group(m_alloc, m_root);
+		}
+	_alloc_t m_alloc;
 	_group_t* m_root;
+	bool m_persistent;
+	mutable std::atomic<bool> m_shared;
+
+private:
+	// Common
+	template <class _items_t, class _func_t> bool for_each_chunk_internal(_size_t position, _size_t count, _func_t& func)
+		{
+		if(position>get_count()||count>get_count()-position)
+			throw std::out_of_range(nullptr);
+		if(count==0)
+			return true;
+		// Chunks are passed on until the function returns false.
+		auto chunk=[&func](_items_t items, uint16_t chunk_count)
+			{
+			if constexpr(std::is_same<decltype(func(items, chunk_count)), bool>::value)
+				{
+				return func(items, chunk_count);
+				}
+			else
+				{
+				func(items, chunk_count);
+				return true;
+				}
+			};
+		return m_root->for_each_chunk(position, count, chunk);
+		}
+	_group_t* graft_group(_group_t* group, _parent_group_t** root_ptr)
+		{
+		uint16_t level=m_root->get_level();
+		uint16_t tail_level=group->get_level();
+		auto root=_allocator_t::template create<_parent_group_t>(m_alloc, (uint16_t)(std::max(level, tail_level)+1));
+		*root_ptr=root;
+		try
+			{
+			if(level>tail_level)
+				return ((_parent_group_t*)m_root)->append_group(m_alloc, group);
+			if(level<tail_level)
+				{
+				auto head=((_parent_group_t*)group)->prepend_group(m_alloc, m_root);
+				if(!head)
+					{
+					m_root=group;
+					return nullptr;
+					}
+				m_root=head;
+				}
+			return group;
+			}
+		catch(...)
+			{
+			_allocator_t::free_group(m_alloc, root);
+			throw;
+			}
+		}
+};
+
+
+//=========
+// Builder
+//=========
+
+// Builds a cluster bottom-up from items in order.
+// All groups are filled completely, except the last one of each level.
+
+template <class _traits_t>
+class cluster_builder
+{
+public:
+	// Using
+	using _alloc_t=typename _traits_t::alloc_t;
+	using _allocator_t=cluster_allocator<_traits_t>;
+	using _item_t=typename _traits_t::item_t;
+	using _group_t=typename _traits_t::group_t;
+	using _item_group_t=typename _traits_t::item_group_t;
+	using _parent_group_t=typename _traits_t::parent_group_t;
+	using _size_t=typename _traits_t::size_t;
+	static const uint16_t _group_size=_traits_t::group_size;
+
+	// Con-/Destructors
+	cluster_builder(_alloc_t& alloc)noexcept: m_alloc(alloc), m_groups(), m_level_count(0) {}
+	cluster_builder(cluster_builder const&)=delete;
+	~cluster_builder()noexcept
+		{
+		for(uint16_t u=0; u<m_level_count; u++)
+			{
+			if(m_groups[u])
+				_allocator_t::free_group(m_alloc, m_groups[u]);
+			}
+		}
+
+	// Modification
+	template <class... _args_t> _item_t& emplace(_args_t&&... args)
+		{
+		auto group=(_item_group_t*)m_groups[0];
+		if(!group||group->get_child_count()==_group_size)
+			{
+			if(group)
+				push_group(1);
+			group=_allocator_t::template create<_item_group_t>(m_alloc);
+			m_groups[0]=group;
+			if(m_level_count==0)
+				m_level_count=1;
+			}
+		return *group->emplace_item(group->get_child_count(), std::forward<_args_t>(args)...);
+		}
+	_group_t* finish()
+		{
+		for(uint16_t u=1; u<m_level_count; u++)
+			{
+			if(m_groups[u-1])
+				push_group(u);
+			}
+		if(m_level_count==0)
+			return nullptr;
+		uint16_t top=(uint16_t)(m_level_count-1);
+		auto root=m_groups[top];
+		m_groups[top]=nullptr;
+		m_level_count=0;
+		return root;
+		}
+
+private:
+	// Modification
+	void push_group(uint16_t level)
+		{
+		auto parent=(_parent_group_t*)m_groups[level];
+		if(!parent||parent->get_child_count()==_group_size)
+			{
+			if(parent)
+				push_group((uint16_t)(level+1));
+			parent=_allocator_t::template create<_parent_group_t>(m_alloc, level);
+			m_groups[level]=parent;
+			if(level>=m_level_count)
+				m_level_count=(uint16_t)(level+1);
+			}
+		parent->insert_groups(parent->get_child_count(), &m_groups[level-1], 1);
+		m_groups[level-1]=nullptr;
+		}
+
+	// Common
+	_alloc_t& m_alloc;
+	_group_t* m_groups[sizeof(_size_t)*8];
+	uint16_t m_level_count;
 };
 
 
@@ -661,6 +1686,11 @@ public:
 		{
 		if(!m_current)
 			throw std::out_of_range(nullptr);
+		if constexpr(!_is_const)
+			{
+			if(m_cluster->m_shared.load(std::memory_order_relaxed))
+				const_cast<cluster_iterator_base*>(this)->unshare_current();
+			}
 		return *m_current;
 		}
 	inline bool has_current()const noexcept { return m_current!=nullptr; }
@@ -844,15 +1874,7 @@ protected:
 			return group_pos;
 			}
 		_parent_group_t* parent_group=(_parent_group_t*)group;
-		for(uint16_t u=0; u<child_count; u++)
-			{
-			_group_t* child=parent_group->get_child(u);
-			_size_t item_count=child->get_item_count();
-			if(*position<item_count)
-				return u;
-			*position-=item_count;
-			}
-		return _group_size;
+		return parent_group->get_group(position);
 		}
 	inline bool is_outside()const noexcept { return is_outside(m_position); }
 	bool is_outside(_size_t position)const noexcept
@@ -878,6 +1900,24 @@ protected:
 			m_its=(it_pointer*)operator new(level_count*sizeof(it_pointer));
 		m_level_count=level_count;
 		}
+	void unshare_current()
+		{
+		// Shared groups are copied along the path before the current item is accessed,
+		// the path is looked-up again if it has been copied by another iterator.
+		_group_t* group=m_cluster->m_root;
+		for(uint16_t u=0; u<m_level_count; u++)
+			{
+			auto it_ptr=&m_its[u];
+			if(it_ptr->group!=group||group->is_shared())
+				{
+				m_cluster->unshare(m_position, m_position);
+				cluster_iterator_base::set_position(m_position);
+				return;
+				}
+			if(u+1<m_level_count)
+				group=((_parent_group_t*)group)->get_child(it_ptr->position);
+			}
+		}
 	_cluster_ptr m_cluster;
 	_item_ptr m_current;
 	it_pointer* m_its;
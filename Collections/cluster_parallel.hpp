@@ -0,0 +1,122 @@
+//======================
+// cluster_parallel.hpp
+//======================
+
+// Parallel processing of the items of a cluster.
+// Tasks are taken by the threads in turn,
+// positions are divided in blocks of fixed size.
+
+// Copyright 2026, Sven Bieg (svenbieg@outlook.de)
+// https://github.com/svenbieg/Clusters
+
+#pragma once
+
+
+//=======
+// Using
+//=======
+
+#include <atomic>
+#include <exception>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+
+//===========
+// Namespace
+//===========
+
+namespace Collections {
+
+
+//==========
+// Parallel
+//==========
+
+class cluster_parallel
+{
+public:
+	// Settings
+	static const uint32_t block_size=16384;
+
+	// Access
+	template <class _size_t> static inline _size_t get_block_count(_size_t count)noexcept
+		{
+		return (_size_t)(count/block_size+(count%block_size? 1: 0));
+		}
+	static unsigned int get_thread_count(unsigned int thread_count, uint64_t task_count)noexcept
+		{
+		if(thread_count==0)
+			thread_count=std::thread::hardware_concurrency();
+		if(thread_count>task_count)
+			thread_count=(unsigned int)task_count;
+		if(thread_count==0)
+			thread_count=1;
+		return thread_count;
+		}
+
+	// Common
+	template <class _size_t, class _func_t> static void run(_size_t count, unsigned int thread_count, _func_t& func)
+		{
+		auto block=[count, &func](unsigned int, uint64_t block)
+			{
+			_size_t position=(_size_t)(block*block_size);
+			_size_t item_count=count-position;
+			if(item_count>block_size)
+				item_count=block_size;
+			func((_size_t)block, position, item_count);
+			};
+		run_tasks(get_block_count(count), thread_count, block);
+		}
+	template <class _func_t> static void run_tasks(uint64_t task_count, unsigned int thread_count, _func_t& func)
+		{
+		if(task_count==0)
+			return;
+		thread_count=get_thread_count(thread_count, task_count);
+		std::atomic<uint64_t> next(0);
+		std::atomic<bool> failed(false);
+		std::vector<std::exception_ptr> errors(thread_count);
+		auto task=[&](unsigned int thread)
+			{
+			try
+				{
+				for(uint64_t u=next++; u<task_count; u=next++)
+					{
+					if(failed)
+						break;
+					func(thread, u);
+					}
+				}
+			catch(...)
+				{
+				errors[thread]=std::current_exception();
+				failed=true;
+				}
+			};
+		std::vector<std::thread> threads;
+		threads.reserve(thread_count-1);
+		try
+			{
+			for(unsigned int u=1; u<thread_count; u++)
+				threads.emplace_back(task, u);
+			}
+		catch(...)
+			{
+			failed=true;
+			for(auto& thread: threads)
+				thread.join();
+			throw;
+			}
+		task(0);
+		for(auto& thread: threads)
+			thread.join();
+		for(auto& error: errors)
+			{
+			if(error)
+				std::rethrow_exception(error);
+			}
+		}
+};
+
+}
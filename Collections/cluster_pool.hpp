@@ -0,0 +1,201 @@
+//==================
+// cluster_pool.hpp
+//==================
+
+// Allocators for the groups of a cluster.
+// Freed groups are kept in size-classes and reused.
+
+// Copyright 2026, Sven Bieg (svenbieg@outlook.de)
+// https://github.com/svenbieg/Clusters
+
+#pragma once
+
+
+//=======
+// Using
+//=======
+
+#include <memory_resource>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+
+//===========
+// Namespace
+//===========
+
+namespace Collections {
+
+
+//======
+// Pool
+//======
+
+class cluster_pool
+{
+public:
+	// Con-/Destructors
+	cluster_pool()noexcept: m_classes() {}
+	cluster_pool(cluster_pool const&)noexcept: m_classes() {}
+	cluster_pool(cluster_pool&& pool)noexcept: m_classes() { move_from(pool); }
+	~cluster_pool()noexcept { clear(); }
+
+	// Assignment
+	inline cluster_pool& operator=(cluster_pool const&)noexcept { return *this; }
+	cluster_pool& operator=(cluster_pool&& pool)noexcept
+		{
+		if(this==&pool)
+			return *this;
+		clear();
+		move_from(pool);
+		return *this;
+		}
+
+	// Comparison
+	// Groups of all pools are allocated on the heap and can be exchanged.
+	inline bool operator==(cluster_pool const&)const noexcept { return true; }
+	inline bool operator!=(cluster_pool const&)const noexcept { return false; }
+
+	// Allocation
+	void* allocate(size_t size, size_t align)
+		{
+		auto size_class=get_class(size, align);
+		if(size_class&&size_class->first)
+			{
+			auto block=size_class->first;
+			size_class->first=block->next;
+			size_class->count--;
+			return block;
+			}
+		if(align>__STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			return operator new(size, std::align_val_t(align));
+		return operator new(size);
+		}
+	void deallocate(void* buf, size_t size, size_t align)noexcept
+		{
+		auto size_class=get_class(size, align);
+		if(!size_class||size_class->count==_max_count)
+			{
+			free_block(buf, align);
+			return;
+			}
+		auto block=(free_block_t*)buf;
+		block->next=size_class->first;
+		size_class->first=block;
+		size_class->count++;
+		}
+
+	// Modification
+	void clear()noexcept
+		{
+		for(uint16_t u=0; u<_class_count; u++)
+			{
+			auto size_class=&m_classes[u];
+			while(size_class->first)
+				{
+				auto block=size_class->first;
+				size_class->first=block->next;
+				free_block(block, size_class->align);
+				}
+			*size_class=size_class_t();
+			}
+		}
+
+private:
+	// Settings
+	static const uint16_t _class_count=4;
+	static const uint32_t _max_count=256;
+
+	// Size-Class
+	struct free_block_t
+		{
+		free_block_t* next;
+		};
+	struct size_class_t
+		{
+		size_t size;
+		size_t align;
+		free_block_t* first;
+		uint32_t count;
+		};
+
+	// Common
+	static void free_block(void* buf, size_t align)noexcept
+		{
+		if(align>__STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			{
+			operator delete(buf, std::align_val_t(align));
+			return;
+			}
+		operator delete(buf);
+		}
+	size_class_t* get_class(size_t size, size_t align)noexcept
+		{
+		if(size<sizeof(free_block_t))
+			return nullptr;
+		for(uint16_t u=0; u<_class_count; u++)
+			{
+			auto size_class=&m_classes[u];
+			if(size_class->size==0)
+				{
+				size_class->size=size;
+				size_class->align=align;
+				return size_class;
+				}
+			if(size_class->size==size&&size_class->align==align)
+				return size_class;
+			}
+		return nullptr;
+		}
+	void move_from(cluster_pool& pool)noexcept
+		{
+		for(uint16_t u=0; u<_class_count; u++)
+			{
+			m_classes[u]=pool.m_classes[u];
+			pool.m_classes[u]=size_class_t();
+			}
+		}
+	size_class_t m_classes[_class_count];
+};
+
+
+//==========
+// Parallel
+//==========
+
+// Allocators are copied for every thread, the groups have to be exchangeable.
+
+template <class _alloc_t> struct cluster_alloc_parallel: std::false_type {};
+template <> struct cluster_alloc_parallel<cluster_pool>: std::true_type {};
+
+
+//==========
+// PMR-Pool
+//==========
+
+class cluster_pmr_pool
+{
+public:
+	// Con-/Destructors
+	cluster_pmr_pool()noexcept: m_resource(std::pmr::get_default_resource()) {}
+	cluster_pmr_pool(std::pmr::memory_resource* resource)noexcept: m_resource(resource) {}
+
+	// Access
+	inline std::pmr::memory_resource* get_resource()const noexcept { return m_resource; }
+
+	// Comparison
+	inline bool operator==(cluster_pmr_pool const& pool)const noexcept { return m_resource==pool.m_resource||m_resource->is_equal(*pool.m_resource); }
+	inline bool operator!=(cluster_pmr_pool const& pool)const noexcept { return !operator==(pool); }
+
+	// Allocation
+	inline void* allocate(size_t size, size_t align) { return m_resource->allocate(size, align); }
+	inline void deallocate(void* buf, size_t size, size_t align)noexcept { m_resource->deallocate(buf, size, align); }
+
+private:
+	// Common
+	std::pmr::memory_resource* m_resource;
+};
+
+}
@@ -0,0 +1,324 @@
+//====================
+// concurrent_map.hpp
+//====================
+
+// Thread-safe implementation of a sorted map with concurrent writers.
+// The groups of the deepest level with up to 64 groups are latched separately,
+// items in different groups can be inserted and removed at the same time.
+
+// Copyright 2026, Sven Bieg (svenbieg@outlook.de)
+// https://github.com/svenbieg/Clusters/wiki/Map
+
+#pragma once
+
+
+//=======
+// Using
+//=======
+
+#include "Collections/map.hpp"
+#include "Collections/shared_cluster.hpp"
+
+
+//===========
+// Namespace
+//===========
+
+namespace Collections {
+
+
+//================
+// Concurrent Map
+//================
+
+template <typename _key_t, typename _value_t, typename _size_t=uint32_t, uint16_t _group_size=10, class _alloc_t=cluster_pool, class _compare_t=index_compare>
+class concurrent_map: protected map<_key_t, _value_t, _size_t, _group_size, _alloc_t, _compare_t>
+{
+public:
+	// Using
+	using _traits_t=map_traits<_key_t, _value_t, _size_t, _group_size, _alloc_t, _compare_t>;
+	using _cluster_t=typename _traits_t::cluster_t;
+	using _group_t=typename _traits_t::group_t;
+	using _item_t=typename _traits_t::item_t;
+	using _order_t=index_order<_compare_t>;
+	using _parent_group_t=typename _traits_t::parent_group_t;
+
+	// Con-/Destructors
+	concurrent_map(): m_dirty(false), m_level(0), m_split_count(0) {}
+	concurrent_map(concurrent_map const&)=delete;
+
+	// Access
+	template <class _key_param_t> inline _value_t operator[](_key_param_t const& key) { return get(key); }
+	template <class _key_param_t> bool contains(_key_param_t const& key)
+		{
+		return read_child(key, [](_item_t const* item) { return item!=nullptr; });
+		}
+	template <class _key_param_t> _value_t get(_key_param_t const& key)
+		{
+		// Missing values are created like in set().
+		_value_t value;
+		if(try_get(key, &value))
+			return value;
+		int got=write_child(key, [&](_alloc_t& alloc, _group_t* child)
+			{
+			bool created=false;
+			auto item=child->emplace(alloc, key, &created, false, std::piecewise_construct, key);
+			if(!item)
+				return -1;
+			value=item->get_value();
+			return 1;
+			});
+		if(got>=0)
+			return value;
+		return write_root([&]() { return _cluster_t::get(key); });
+		}
+	_size_t get_count()
+		{
+		return m_mutex.read([&]()
+			{
+			auto root=this->m_root;
+			if(!root)
+				return (_size_t)0;
+			if(m_split_count==0)
+				return root->get_item_count();
+			_size_t count=0;
+			for(uint16_t u=0; u<m_split_count; u++)
+				{
+				std::shared_lock<std::shared_mutex> latch(m_latches[u].mutex);
+				count+=m_groups[u]->get_item_count();
+				}
+			return count;
+			});
+		}
+	_cluster_t snapshot()
+		{
+		_cluster_t snapshot(this->m_alloc);
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		update_root();
+		if constexpr(cluster_alloc_parallel<_alloc_t>::value)
+			{
+			// The latched groups are unshared with the next write of the root.
+			this->share_to(snapshot);
+			m_split_count=0;
+			}
+		else
+			{
+			snapshot.copy_from(*this);
+			}
+		return snapshot;
+		}
+	template <class _key_param_t> bool try_get(_key_param_t const& key, _value_t* value)
+		{
+		return read_child(key, [value](_item_t const* item)
+			{
+			if(!item)
+				return false;
+			*value=item->get_value();
+			return true;
+			});
+		}
+
+	// Modification
+	template <class _key_param_t, class _value_param_t> inline bool add(_key_param_t const& key, _value_param_t const& value) { return try_emplace(key, value); }
+	bool clear()
+		{
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		m_dirty=false;
+		m_split_count=0;
+		return _cluster_t::clear();
+		}
+	template <class _key_param_t> bool remove(_key_param_t const& key)
+		{
+		// Items are removed with the unique lock if the child would be empty.
+		int removed=write_child(key, [&](_alloc_t& alloc, _group_t* child)
+			{
+			_size_t count=child->get_item_count();
+			if(count<2)
+				return -1;
+			if(child->get_level()>0)
+				{
+				_size_t pos=child->get_lower_bound(key);
+				if(pos==count)
+					pos--;
+				((_parent_group_t*)child)->unshare(alloc, pos, pos);
+				}
+			return child->remove(alloc, key, nullptr)? 1: 0;
+			});
+		if(removed>=0)
+			return removed>0;
+		return write_root([&]() { return _cluster_t::remove(key); });
+		}
+	template <class _key_param_t, class _value_param_t> bool set(_key_param_t const& key, _value_param_t const& value)
+		{
+		int changed=write_child(key, [&](_alloc_t& alloc, _group_t* child)
+			{
+			bool created=false;
+			auto item=child->emplace(alloc, key, &created, false, std::piecewise_construct, key, value);
+			if(!item)
+				return -1;
+			if(created)
+				return 1;
+			if(item->get_value()==value)
+				return 0;
+			item->set_value(value);
+			return 1;
+			});
+		if(changed>=0)
+			return changed>0;
+		return write_root([&]() { return _cluster_t::set(key, value); });
+		}
+	template <class _key_param_t, class... _args_t> bool try_emplace(_key_param_t const& key, _args_t const&... args)
+		{
+		int created=write_child(key, [&](_alloc_t& alloc, _group_t* child)
+			{
+			bool item_created=false;
+			if(!child->emplace(alloc, key, &item_created, false, std::piecewise_construct, key, args...))
+				return -1;
+			return item_created? 1: 0;
+			});
+		if(created>=0)
+			return created>0;
+		return write_root([&]() { return _cluster_t::try_emplace(key, args...); });
+		}
+
+private:
+	// Settings
+	static const uint16_t _latch_count=64;
+
+	// Latch
+	struct alignas(64) latch_t
+		{
+		std::shared_mutex mutex;
+		_alloc_t alloc;
+		};
+
+	// Common
+	template <class _key_param_t> uint16_t get_child(_key_param_t const& key)const noexcept
+		{
+		// Keys of a child are between its split and the next one.
+		uint16_t start=1;
+		uint16_t end=m_split_count;
+		while(start<end)
+			{
+			uint16_t pos=start+(end-start)/2;
+			if(_order_t::compare(m_splits[pos], key)>0)
+				{
+				end=pos;
+				}
+			else
+				{
+				start=pos+1;
+				}
+			}
+		return start-1;
+		}
+	template <class _key_param_t, class _func_t> bool read_child(_key_param_t const& key, _func_t&& func)
+		{
+		return m_mutex.read([&]()
+			{
+			auto root=this->m_root;
+			if(!root)
+				return func(nullptr);
+			if(m_split_count==0)
+				return func(root->get(key));
+			uint16_t pos=get_child(key);
+			std::shared_lock<std::shared_mutex> latch(m_latches[pos].mutex);
+			return func(m_groups[pos]->get(key));
+			});
+		}
+	void update_group(_group_t* group)noexcept
+		{
+		if(group->get_level()<=m_level)
+			return;
+		auto parent=(_parent_group_t*)group;
+		uint16_t child_count=parent->get_child_count();
+		for(uint16_t u=0; u<child_count; u++)
+			update_group(parent->get_child(u));
+		parent->update_item_counts();
+		parent->update_bounds();
+		}
+	void update_root()noexcept
+		{
+		// The counts and bounds above the latched groups are updated with the unique lock.
+		if(!m_dirty)
+			return;
+		update_group(this->m_root);
+		m_dirty=false;
+		}
+	void update_splits()
+		{
+		// The groups above the latched level are unshared, they are not written concurrently.
+		m_split_count=0;
+		this->unshare_root();
+		auto root=this->m_root;
+		if(!root||root->get_level()==0)
+			return;
+		auto parent=(_parent_group_t*)root;
+		parent->unshare_children(this->m_alloc);
+		uint16_t count=parent->get_child_count();
+		for(uint16_t u=0; u<count; u++)
+			m_groups[u]=parent->get_child(u);
+		uint16_t level=(uint16_t)(root->get_level()-1);
+		while(level>0)
+			{
+			uint32_t next_count=0;
+			for(uint16_t u=0; u<count; u++)
+				next_count+=m_groups[u]->get_child_count();
+			if(next_count>_latch_count)
+				break;
+			// The children are moved in place, beginning at the back.
+			uint16_t dst=(uint16_t)next_count;
+			for(uint16_t u=count; u>0; u--)
+				{
+				parent=(_parent_group_t*)m_groups[u-1];
+				parent->unshare_children(this->m_alloc);
+				uint16_t child_count=parent->get_child_count();
+				dst=(uint16_t)(dst-child_count);
+				for(uint16_t v=0; v<child_count; v++)
+					m_groups[dst+v]=parent->get_child(v);
+				}
+			count=(uint16_t)next_count;
+			level--;
+			}
+		for(uint16_t u=1; u<count; u++)
+			m_splits[u]=m_groups[u]->get_first();
+		m_level=level;
+		m_split_count=count;
+		}
+	template <class _func_t> auto write_root(_func_t&& func)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		update_root();
+		m_split_count=0;
+		auto result=func();
+		update_splits();
+		return result;
+		}
+	template <class _key_param_t, class _func_t> int write_child(_key_param_t const& key, _func_t&& func)
+		{
+		// Returns -1 if the root needs to be modified with the unique lock.
+		if constexpr(!cluster_alloc_parallel<_alloc_t>::value)
+			return -1;
+		return m_mutex.read([&]()
+			{
+			if(m_split_count==0)
+				return -1;
+			uint16_t pos=get_child(key);
+			auto latch=&m_latches[pos];
+			std::unique_lock<std::shared_mutex> lock(latch->mutex);
+			// Bounds above can point to moved items of the group.
+			if(!m_dirty.load(std::memory_order_relaxed))
+				m_dirty.store(true, std::memory_order_relaxed);
+			return func(latch->alloc, m_groups[pos]);
+			});
+		}
+	std::atomic<bool> m_dirty;
+	uint16_t m_level;
+	latch_t m_latches[_latch_count];
+	shared_cluster_mutex m_mutex;
+	_group_t* m_groups[_latch_count];
+	uint16_t m_split_count;
+	_key_t m_splits[_latch_count];
+};
+
+}
\ No newline at end of file
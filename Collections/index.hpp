@@ -16,6 +16,7 @@
 //=======
 
 #include "Collections/cluster.hpp"
+#include "Collections/index_search.hpp"
 
 
 //===========
@@ -40,25 +41,71 @@ equal
 };
 
 
+//=======
+// Bound
+//=======
+
+// Boundary-key of a child in a parent-group.
+// Small trivially copyable keys are copied, others are referenced.
+
+template <class _key_t>
+struct index_key_copy: std::integral_constant<bool, std::is_trivially_copyable<_key_t>::value&&sizeof(_key_t)<=2*sizeof(uint64_t)> {};
+
+template <class _key_t, bool _copy=index_key_copy<_key_t>::value>
+class index_bound
+{
+public:
+	// Access
+	inline _key_t const& get()const noexcept { return m_key; }
+
+	// Modification
+	inline void set(_key_t const& key)noexcept { m_key=key; }
+
+private:
+	// Common
+	_key_t m_key;
+};
+
+template <class _key_t>
+class index_bound<_key_t, false>
+{
+public:
+	// Con-/Destructors
+	index_bound()noexcept: m_key(nullptr) {}
+
+	// Access
+	inline _key_t const& get()const noexcept { return *m_key; }
+
+	// Modification
+	inline void set(_key_t const& key)noexcept { m_key=&key; }
+
+private:
+	// Common
+	_key_t const* m_key;
+};
+
+
 //======================
 // Forward-Declarations
 //======================
 
-template <class _item_t, typename _size_t, uint16_t _group_size> class index;
-template <class _item_t, typename _size_t, uint16_t _group_size> class index_group;
-template <class _item_t, typename _size_t, uint16_t _group_size> class index_item_group;
-template <class _item_t, typename _size_t, uint16_t _group_size> class index_parent_group;
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t> class index;
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t> class index_group;
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t> class index_item_group;
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t> class index_parent_group;
 template <class _traits_t, bool _is_const> class index_iterator;
 template <class _traits_t, bool _is_const> class shared_index_iterator;
 
-template <class _item_t, typename _size_t, uint16_t _group_size>
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t>
 struct index_traits
 {
+using alloc_t=_alloc_t;
+using compare_t=_compare_t;
 using item_t=_item_t;
-using group_t=index_group<_item_t, _size_t, _group_size>;
-using item_group_t=index_item_group<_item_t, _size_t, _group_size>;
-using parent_group_t=index_parent_group<_item_t, _size_t, _group_size>;
-using cluster_t=index<_item_t, _size_t, _group_size>;
+using group_t=index_group<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+using item_group_t=index_item_group<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+using parent_group_t=index_parent_group<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+using cluster_t=index<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
 using iterator_t=index_iterator<index_traits, false>;
 using const_iterator_t=index_iterator<index_traits, true>;
 using shared_iterator_t=shared_index_iterator<index_traits, false>;
@@ -72,20 +119,181 @@ static const uint16_t group_size=_group_size;
 // Group
 //=======
 
-template <class _item_t, typename _size_t, uint16_t _group_size>
-class index_group: public cluster_group<index_traits<_item_t, _size_t, _group_size>>
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t>
+class index_group: public cluster_group<index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>>
 {
 public:
+	// Using
+	using _traits_t=index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+	using _base_t=cluster_group<_traits_t>;
+	using _item_group_t=typename _traits_t::item_group_t;
+	using _key_t=typename index_key<_item_t>::key_t;
+	using _parent_group_t=typename _traits_t::parent_group_t;
+
 	// Access
-	virtual uint16_t find(_item_t const& item, bool* exists, find_func func)const noexcept=0;
-	virtual _item_t const* get(_item_t const& item)const noexcept=0;
-	virtual _item_t* get(_item_t&& item, bool* created, bool again)=0;
-	virtual _item_t const& get_first()const noexcept=0;
-	virtual _item_t const& get_last()const noexcept=0;
-	virtual bool index_of(_item_t const& item, _size_t* pos_ptr)const noexcept=0;
+	template <class _key_param_t> uint16_t find(_key_param_t const& key, bool* exists, find_func func)const noexcept
+		{
+		if(this->m_level==0)
+			return ((_item_group_t const*)this)->find(key, exists, func);
+		return ((_parent_group_t const*)this)->find(key, exists, func);
+		}
+	template <class _key_param_t> _item_t const* get(_key_param_t const& key)const noexcept
+		{
+		if(this->m_level==0)
+			return ((_item_group_t const*)this)->get(key);
+		return ((_parent_group_t const*)this)->get(key);
+		}
+	template <class _key_param_t, class... _args_t> _item_t* emplace(_alloc_t& alloc, _key_param_t const& key, bool* created, bool again, _args_t&&... args)
+		{
+		if(this->m_level==0)
+			return ((_item_group_t*)this)->emplace(alloc, key, created, again, std::forward<_args_t>(args)...);
+		return ((_parent_group_t*)this)->emplace(alloc, key, created, again, std::forward<_args_t>(args)...);
+		}
+	_size_t add_many(_alloc_t& alloc, _item_t const* const* items, _size_t count, bool replace, _size_t* created_ptr)
+		{
+		if(this->m_level==0)
+			return ((_item_group_t*)this)->add_many(alloc, items, count, replace, created_ptr);
+		return ((_parent_group_t*)this)->add_many(alloc, items, count, replace, created_ptr);
+		}
+	inline _key_t const& get_first()const noexcept
+		{
+		if(this->m_level==0)
+			return ((_item_group_t const*)this)->get_first();
+		return ((_parent_group_t const*)this)->get_first();
+		}
+	inline _key_t const& get_last()const noexcept
+		{
+		if(this->m_level==0)
+			return ((_item_group_t const*)this)->get_last();
+		return ((_parent_group_t const*)this)->get_last();
+		}
+	template <class _key_param_t> _size_t get_lower_bound(_key_param_t const& key)const noexcept
+		{
+		if(this->m_level==0)
+			return ((_item_group_t const*)this)->get_lower_bound(key);
+		return ((_parent_group_t const*)this)->get_lower_bound(key);
+		}
+	template <class _key_param_t> bool index_of(_key_param_t const& key, _size_t* pos_ptr)const noexcept
+		{
+		if(this->m_level==0)
+			return ((_item_group_t const*)this)->index_of(key, pos_ptr);
+		return ((_parent_group_t const*)this)->index_of(key, pos_ptr);
+		}
 
 	// Modification
-	virtual bool remove(_item_t const& item, _item_t* item_ptr)noexcept=0;
+	template <class _key_param_t> bool remove(_alloc_t& alloc, _key_param_t const& key, _item_t* item_ptr)noexcept
+		{
+		if(this->m_level==0)
+			return ((_item_group_t*)this)->remove(alloc, key, item_ptr);
+		return ((_parent_group_t*)this)->remove(alloc, key, item_ptr);
+		}
+
+protected:
+	// Con-/Destructors
+	using _base_t::_base_t;
+};
+
+
+//===========
+// Key-Group
+//===========
+
+// Item-group searching the keys of its items.
+// Keys of compound items are kept in a separate array,
+// so the search doesn't touch the values.
+
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t,
+	bool _separate=!std::is_same<typename index_key<_item_t>::key_t, _item_t>::value&&index_key_copy<typename index_key<_item_t>::key_t>::value>
+class index_key_group: public cluster_item_group<index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>>
+{
+public:
+	// Using
+	using _traits_t=index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+	using _base_t=cluster_item_group<_traits_t>;
+	using _item_key_t=index_key<_item_t>;
+	using _key_t=typename _item_key_t::key_t;
+
+	// Con-/Destructors
+	using _base_t::_base_t;
+
+	// Access
+	inline _key_t const& get_key(uint16_t position)const noexcept { return _item_key_t::get(this->get_items()[position]); }
+
+protected:
+	// Access
+	template <class _key_param_t> inline uint16_t get_item_pos(_key_param_t const& key, bool* exists)const noexcept
+		{
+		return index_search<_item_t, _compare_t>::get_item_pos(this->get_items(), this->m_item_count, key, exists);
+		}
+};
+
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t>
+class index_key_group<_item_t, _size_t, _group_size, _alloc_t, _compare_t, true>: public cluster_item_group<index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>>
+{
+public:
+	// Using
+	using _traits_t=index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+	using _base_t=cluster_item_group<_traits_t>;
+	using _item_key_t=index_key<_item_t>;
+	using _key_t=typename _item_key_t::key_t;
+
+	// Con-/Destructors
+	index_key_group()noexcept: _base_t(), m_keys() {}
+
+	// Access
+	inline _key_t const& get_key(uint16_t position)const noexcept { return m_keys[position]; }
+
+	// Modification
+	template <class... _args_t> _item_t* emplace_item(uint16_t position, _args_t&&... args)
+		{
+		_item_t* inserted=_base_t::emplace_item(position, std::forward<_args_t>(args)...);
+		if(inserted)
+			update_keys(position);
+		return inserted;
+		}
+	inline _item_t* insert_item(uint16_t position, _item_t const& insert) { return emplace_item(position, insert); }
+	inline _item_t* insert_item(uint16_t position, _item_t&& insert)noexcept { return emplace_item(position, std::move(insert)); }
+	uint16_t insert_items(uint16_t position, _item_t* insert, uint16_t count)noexcept
+		{
+		count=_base_t::insert_items(position, insert, count);
+		update_keys(position);
+		return count;
+		}
+	uint16_t insert_items(uint16_t position, _item_t const* insert, uint16_t count)
+		{
+		count=_base_t::insert_items(position, insert, count);
+		update_keys(position);
+		return count;
+		}
+	void remove_at(_alloc_t& alloc, _size_t position, _item_t* item_ptr)
+		{
+		_base_t::remove_at(alloc, position, item_ptr);
+		update_keys((uint16_t)position);
+		}
+	void remove_items(uint16_t position, uint16_t count)noexcept
+		{
+		_base_t::remove_items(position, count);
+		update_keys(position);
+		}
+
+protected:
+	// Access
+	template <class _key_param_t> inline uint16_t get_item_pos(_key_param_t const& key, bool* exists)const noexcept
+		{
+		return index_search<_key_t, _compare_t>::get_item_pos(m_keys, this->m_item_count, key, exists);
+		}
+
+private:
+	// Modification
+	void update_keys(uint16_t position)noexcept
+		{
+		auto items=this->get_items();
+		for(uint16_t u=position; u<this->m_item_count; u++)
+			m_keys[u]=_item_key_t::get(items[u]);
+		}
+
+	// Common
+	_key_t m_keys[_group_size];
 };
 
 
@@ -93,24 +301,26 @@ public:
 // Item-Group
 //============
 
-template <class _item_t, typename _size_t, uint16_t _group_size>
-class index_item_group: public cluster_item_group<index_traits<_item_t, _size_t, _group_size>>
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t>
+class index_item_group: public index_key_group<_item_t, _size_t, _group_size, _alloc_t, _compare_t>
 {
 public:
 	// Using
-	using _traits_t=index_traits<_item_t, _size_t, _group_size>;
-	using _base_t=cluster_item_group<_traits_t>;
+	using _traits_t=index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+	using _base_t=index_key_group<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
 	using _group_t=typename _traits_t::group_t;
 	using _item_group_t=typename _traits_t::item_group_t;
+	using _item_key_t=index_key<_item_t>;
+	using _key_t=typename _item_key_t::key_t;
 
 	// Con-/Destructors
 	using _base_t::_base_t;
 
 	// Access
-	uint16_t find(_item_t const& item, bool* exists_ptr, find_func func)const noexcept override
+	template <class _key_param_t> uint16_t find(_key_param_t const& key, bool* exists_ptr, find_func func)const noexcept
 		{
 		bool exists=false;
-		uint16_t pos=get_item_pos(item, &exists);
+		uint16_t pos=this->get_item_pos(key, &exists);
 		if(exists)
 			{
 			*exists_ptr=true;
@@ -164,21 +374,21 @@ public:
 			}
 		return pos;
 		}
-	_item_t const* get(_item_t const& item)const noexcept override
+	template <class _key_param_t> _item_t const* get(_key_param_t const& key)const noexcept
 		{
 		bool exists=false;
-		uint16_t pos=get_item_pos(item, &exists);
+		uint16_t pos=this->get_item_pos(key, &exists);
 		if(!exists)
 			return nullptr;
 		return &this->get_at(pos);
 		}
-	_item_t* get(_item_t&& item, bool* created, bool again)override
+	template <class _key_param_t, class... _args_t> _item_t* emplace(_alloc_t&, _key_param_t const& key, bool* created, bool, _args_t&&... args)
 		{
 		bool exists=false;
-		uint16_t pos=get_item_pos(item, &exists);
+		uint16_t pos=this->get_item_pos(key, &exists);
 		if(exists)
-			return &this->get_at(pos);
-		_item_t* inserted=this->insert_item(pos, std::forward<_item_t>(item));
+			return &this->get_items()[pos];
+		_item_t* inserted=this->emplace_item(pos, std::forward<_args_t>(args)...);
 		if(inserted)
 			{
 			*created=true;
@@ -186,12 +396,38 @@ public:
 			}
 		return nullptr;
 		}
-	inline _item_t const& get_first()const noexcept override { return this->get_first_item(); }
-	inline _item_t const& get_last()const noexcept override { return this->get_last_item(); }
-	bool index_of(_item_t const& item, _size_t* pos_ptr)const noexcept override
+	_size_t add_many(_alloc_t&, _item_t const* const* items, _size_t count, bool replace, _size_t* created_ptr)
+		{
+		_size_t pos=0;
+		for(; pos<count; pos++)
+			{
+			_item_t const& item=*items[pos];
+			bool exists=false;
+			uint16_t item_pos=this->get_item_pos(_item_key_t::get(item), &exists);
+			if(exists)
+				{
+				if(replace)
+					this->get_items()[item_pos]=item;
+				continue;
+				}
+			if(this->m_item_count==_group_size)
+				break;
+			this->emplace_item(item_pos, item);
+			(*created_ptr)++;
+			}
+		return pos;
+		}
+	inline _key_t const& get_first()const noexcept { return this->get_key(0); }
+	inline _key_t const& get_last()const noexcept { return this->get_key((uint16_t)(this->m_item_count-1)); }
+	template <class _key_param_t> inline _size_t get_lower_bound(_key_param_t const& key)const noexcept
+		{
+		bool exists=false;
+		return this->get_item_pos(key, &exists);
+		}
+	template <class _key_param_t> bool index_of(_key_param_t const& key, _size_t* pos_ptr)const noexcept
 		{
 		bool exists=false;
-		uint16_t pos=get_item_pos(item, &exists);
+		uint16_t pos=this->get_item_pos(key, &exists);
 		if(!exists)
 			return false;
 		if(pos_ptr)
@@ -200,44 +436,15 @@ public:
 		}
 
 	// Modification
-	bool remove(_item_t const& item, _item_t* item_ptr)noexcept override
+	template <class _key_param_t> bool remove(_alloc_t& alloc, _key_param_t const& key, _item_t* item_ptr)noexcept
 		{
 		bool exists=false;
-		uint16_t pos=get_item_pos(item, &exists);
+		uint16_t pos=this->get_item_pos(key, &exists);
 		if(!exists)
 			return false;
-		this->remove_at(pos, item_ptr);
+		this->remove_at(alloc, pos, item_ptr);
 		return true;
 		}
-
-private:
-	// Access
-	uint16_t get_item_pos(_item_t const& item, bool* exists)const noexcept
-		{
-		uint16_t item_count=this->m_item_count;
-		if(item_count==0)
-			return 0;
-		uint16_t start=0;
-		uint16_t end=item_count;
-		while(start<end)
-			{
-			uint16_t pos=(uint16_t)(start+(end-start)/2);
-			_item_t const& cmp=this->get_at(pos);
-			if(cmp>item)
-				{
-				end=pos;
-				continue;
-				}
-			if(cmp<item)
-				{
-				start=(uint16_t)(pos+1);
-				continue;
-				}
-			*exists=true;
-			return pos;
-			}
-		return start;
-		}
 };
 
 
@@ -245,31 +452,33 @@ private:
 // Parent-Group
 //==============
 
-template <class _item_t, typename _size_t, uint16_t _group_size>
-class index_parent_group: public cluster_parent_group<index_traits<_item_t, _size_t, _group_size>>
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t>
+class index_parent_group: public cluster_parent_group<index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>>
 {
 public:
 	// Using
-	using _traits_t=index_traits<_item_t, _size_t, _group_size>;
+	using _traits_t=index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
 	using _base_t=cluster_parent_group<_traits_t>;
 	using _group_t=typename _traits_t::group_t;
 	using _item_group_t=typename _traits_t::item_group_t;
+	using _item_key_t=index_key<_item_t>;
+	using _key_t=typename _item_key_t::key_t;
+	using _bound_t=index_bound<_key_t>;
+	using _order_t=index_order<_compare_t>;
 	using _parent_group_t=typename _traits_t::parent_group_t;
 
 	// Con-Destructors
-	index_parent_group(uint16_t level=1)noexcept: _base_t(level), m_first(nullptr), m_last(nullptr) {}
-	index_parent_group(_parent_group_t const& group)noexcept: _base_t(group)
+	index_parent_group(uint16_t level=1)noexcept: _base_t(level), m_firsts(), m_lasts() {}
+	index_parent_group(_alloc_t& alloc, _parent_group_t const& group): _base_t(alloc, group), m_firsts(), m_lasts()
 		{
-		uint16_t last=(uint16_t)(this->m_child_count-1);
-		m_first=&this->m_children[0]->get_first();
-		m_last=&this->m_children[last]->get_last();
+		update_bounds();
 		}
 
 	// Access
-	uint16_t find(_item_t const& item, bool* exists_ptr, find_func func)const noexcept override
+	template <class _key_param_t> uint16_t find(_key_param_t const& key, bool* exists_ptr, find_func func)const noexcept
 		{
 		uint16_t pos=0;
-		uint16_t count=get_item_pos(item, &pos, false);
+		uint16_t count=get_item_pos(key, &pos, false);
 		if(count==2)
 			{
 			switch(func)
@@ -288,9 +497,7 @@ public:
 			{
 			case find_func::above:
 				{
-				auto group=this->get_child(pos);
-				_item_t const& last=group->get_last();
-				if(last==item)
+				if(_order_t::compare(m_lasts[pos].get(), key)==0)
 					{
 					if(pos+1>=this->m_child_count)
 						return _group_size;
@@ -300,9 +507,7 @@ public:
 				}
 			case find_func::below:
 				{
-				auto group=this->get_child(pos);
-				_item_t const& first=group->get_first();
-				if(first==item)
+				if(_order_t::compare(m_firsts[pos].get(), key)==0)
 					{
 					if(pos==0)
 						return _group_size;
@@ -315,89 +520,166 @@ public:
 			}
 		return pos;
 		}
-	_item_t const* get(_item_t const& item)const noexcept override
+	template <class _key_param_t> _item_t const* get(_key_param_t const& key)const noexcept
 		{
 		uint16_t pos=0;
-		uint16_t count=get_item_pos(item, &pos, true);
+		uint16_t count=get_item_pos(key, &pos, true);
 		for(uint16_t u=0; u<count; u++)
 			{
-			auto got=this->m_children[pos+u]->get(item);
+			auto got=this->m_children[pos+u]->get(key);
 			if(got)
 				return got;
 			}
 		return nullptr;
 		}
-	_item_t* get(_item_t&& item, bool* created_ptr, bool again)override
+	template <class _key_param_t, class... _args_t> _item_t* emplace(_alloc_t& alloc, _key_param_t const& key, bool* created_ptr, bool again, _args_t&&... args)
 		{
+		this->unshare_children(alloc);
 		bool created=false;
-		_item_t* got=get_internal(std::forward<_item_t>(item), &created, again);
-		if(created)
-			{
-			this->m_item_count++;
-			update_bounds();
-			}
+		_item_t* got=emplace_internal(alloc, key, &created, again, std::forward<_args_t>(args)...);
 		if(created_ptr)
 			*created_ptr=created;
 		return got;
 		}
-	inline _item_t const& get_first()const noexcept override { return *m_first; }
-	inline _item_t const& get_last()const noexcept override { return *m_last; }
-	bool index_of(_item_t const& item, _size_t* pos_ptr)const noexcept override
+	_size_t add_many(_alloc_t& alloc, _item_t const* const* items, _size_t count, bool replace, _size_t* created_ptr)
+		{
+		this->unshare_children(alloc);
+		uint16_t pos=0;
+		uint16_t group_count=get_item_pos(_item_key_t::get(*items[0]), &pos, false);
+		for(uint16_t u=0; u<group_count; u++)
+			{
+			uint16_t child=(uint16_t)(pos+u);
+			_size_t run=count;
+			if(child+1<this->m_child_count)
+				run=get_run(items, count, m_firsts[child+1].get());
+			_size_t created=0;
+			_size_t added=this->m_children[child]->add_many(alloc, items, run, replace, &created);
+			if(created)
+				{
+				this->inc_item_count(child, created);
+				update_bound(child);
+				*created_ptr+=created;
+				}
+			if(added)
+				return added;
+			}
+		return 0;
+		}
+	inline _key_t const& get_first()const noexcept { return m_firsts[0].get(); }
+	inline _key_t const& get_last()const noexcept { return m_lasts[this->m_child_count-1].get(); }
+	template <class _key_param_t> _size_t get_lower_bound(_key_param_t const& key)const noexcept
+		{
+		uint16_t pos=0;
+		uint16_t count=get_item_pos(key, &pos, false);
+		if(count==2)
+			return this->get_offset((uint16_t)(pos+1));
+		return this->get_offset(pos)+this->m_children[pos]->get_lower_bound(key);
+		}
+	template <class _key_param_t> bool index_of(_key_param_t const& key, _size_t* pos_ptr)const noexcept
 		{
 		uint16_t group_pos=0;
-		uint16_t count=get_item_pos(item, &group_pos, true);
+		uint16_t count=get_item_pos(key, &group_pos, true);
 		if(count!=1)
 			return false;
 		_size_t pos=0;
-		if(!this->m_children[group_pos]->index_of(item, &pos))
+		if(!this->m_children[group_pos]->index_of(key, &pos))
 			return false;
-		for(uint16_t u=0; u<group_pos; u++)
-			pos+=this->m_children[u]->get_item_count();
 		if(pos_ptr)
-			*pos_ptr=pos;
+			*pos_ptr=pos+this->get_offset(group_pos);
 		return true;
 		}
 
 	// Modification
-	_size_t insert_groups(uint16_t position, _group_t* const* groups, uint16_t count)noexcept override
+	_parent_group_t* append_group(_alloc_t& alloc, _group_t* group)
+		{
+		auto appended=_base_t::append_group(alloc, group);
+		update_bounds();
+		return appended;
+		}
+	_size_t insert_groups(uint16_t position, _group_t* const* groups, uint16_t count)noexcept
 		{
 		_size_t item_count=_base_t::insert_groups(position, groups, count);
 		update_bounds();
 		return item_count;
 		}
-	bool remove(_item_t const& item, _item_t* item_ptr)noexcept override
+	_parent_group_t* prepend_group(_alloc_t& alloc, _group_t* group)
+		{
+		auto prepended=_base_t::prepend_group(alloc, group);
+		update_bounds();
+		return prepended;
+		}
+	template <class _key_param_t> bool remove(_alloc_t& alloc, _key_param_t const& key, _item_t* item_ptr)noexcept
 		{
 		uint16_t pos=0;
-		uint16_t count=get_item_pos(item, &pos, true);
+		uint16_t count=get_item_pos(key, &pos, true);
 		if(count!=1)
 			return false;
-		if(!this->m_children[pos]->remove(item, item_ptr))
+		if(!this->m_children[pos]->remove(alloc, key, item_ptr))
 			return false;
-		this->m_item_count--;
-		this->combine_children(pos);
-		update_bounds();
+		this->dec_item_count(pos);
+		if(this->combine_children(alloc, pos))
+			{
+			update_bounds();
+			}
+		else
+			{
+			update_bound(pos);
+			}
 		return true;
 		}
-	void remove_at(_size_t position, _item_t* item_ptr)override
+	void remove_at(_alloc_t& alloc, _size_t position, _item_t* item_ptr)
 		{
-		_base_t::remove_at(position, item_ptr);
+		_base_t::remove_at(alloc, position, item_ptr);
 		update_bounds();
 		}
-	void remove_groups(uint16_t position, uint16_t count, _size_t item_count)noexcept override
+	void remove_groups(uint16_t position, uint16_t count, _size_t item_count)noexcept
 		{
 		_base_t::remove_groups(position, count, item_count);
 		update_bounds();
 		}
-	void set_child(_group_t* child)noexcept override
+	void remove_range(_alloc_t& alloc, _size_t position, _size_t count)noexcept
+		{
+		_base_t::remove_range(alloc, position, count);
+		update_bounds();
+		}
+	void set_child(_group_t* child)noexcept
 		{
 		_base_t::set_child(child);
-		m_first=&this->m_children[0]->get_first();
-		m_last=&this->m_children[0]->get_last();
+		update_bound(0);
+		}
+	void split_at(_alloc_t& alloc, _size_t position, _parent_group_t* tail)
+		{
+		_base_t::split_at(alloc, position, tail);
+		update_bounds();
+		tail->update_bounds();
+		}
+	void update_bounds()noexcept
+		{
+		for(uint16_t u=0; u<this->m_child_count; u++)
+			update_bound(u);
 		}
 
 private:
 	// Access
-	uint16_t get_item_pos(_item_t const& item, uint16_t* group, bool must_exist)const noexcept
+	static _size_t get_run(_item_t const* const* items, _size_t count, _key_t const& bound)noexcept
+		{
+		_size_t start=0;
+		_size_t end=count;
+		while(start<end)
+			{
+			_size_t pos=start+(end-start)/2;
+			if(_order_t::compare(_item_key_t::get(*items[pos]), bound)<0)
+				{
+				start=pos+1;
+				}
+			else
+				{
+				end=pos;
+				}
+			}
+		return start;
+		}
+	template <class _key_param_t> uint16_t get_item_pos(_key_param_t const& key, uint16_t* group, bool must_exist)const noexcept
 		{
 		uint16_t child_count=this->m_child_count;
 		uint16_t start=0;
@@ -405,15 +687,12 @@ private:
 		while(start<end)
 			{
 			uint16_t pos=(uint16_t)(start+(end-start)/2);
-			auto child=this->m_children[pos];
-			_item_t const& first=child->get_first();
-			_item_t const& last=child->get_last();
-			if(first>item)
+			if(_order_t::compare(m_firsts[pos].get(), key)>0)
 				{
 				end=pos;
 				continue;
 				}
-			if(last<item)
+			if(_order_t::compare(m_lasts[pos].get(), key)<0)
 				{
 				start=(uint16_t)(pos+1);
 				continue;
@@ -428,9 +707,7 @@ private:
 		*group=start;
 		if(start>0)
 			{
-			auto child=this->get_child(start);
-			_item_t const& first=child->get_first();
-			if(first>item)
+			if(_order_t::compare(m_firsts[start].get(), key)>0)
 				{
 				*group=(uint16_t)(start-1);
 				return 2;
@@ -438,64 +715,160 @@ private:
 			}
 		if(start+1<child_count)
 			{
-			auto child=this->get_child(start);
-			_item_t const& last=child->get_last();
-			if(last<item)
+			if(_order_t::compare(m_lasts[start].get(), key)<0)
 				return 2;
 			}
 		return 1;
 		}
 
 	// Modification
-	_item_t* get_internal(_item_t&& item, bool* created_ptr, bool again)
+	template <class _key_param_t, class... _args_t> _item_t* emplace_internal(_alloc_t& alloc, _key_param_t const& key, bool* created_ptr, bool again, _args_t&&... args)
 		{
 		uint16_t pos=0;
-		uint16_t count=get_item_pos(item, &pos, false);
+		uint16_t count=get_item_pos(key, &pos, false);
 		if(!again)
 			{
-			for(uint16_t u=0; u<count; u++)
+			_item_t* got=emplace_child(alloc, pos, count, key, created_ptr, std::forward<_args_t>(args)...);
+			if(got)
+				return got;
+			if(this->shift_children(pos, count))
 				{
-				_item_t* got=this->m_children[pos+u]->get(std::forward<_item_t>(item), created_ptr, false);
+				update_bounds();
+				count=get_item_pos(key, &pos, false);
+				got=emplace_child(alloc, pos, count, key, created_ptr, std::forward<_args_t>(args)...);
 				if(got)
 					return got;
 				}
-			if(this->shift_children(pos, count))
-				{
-				count=get_item_pos(item, &pos, false);
-				for(uint16_t u=0; u<count; u++)
-					{
-					_item_t* got=this->m_children[pos+u]->get(std::forward<_item_t>(item), created_ptr, false);
-					if(got)
-						return got;
-					}
-				}
 			}
-		if(!this->split_child(pos))
+		if(!this->split_child(alloc, pos))
 			return nullptr;
-		count=get_item_pos(item, &pos, false);
+		update_bounds();
+		count=get_item_pos(key, &pos, false);
+		return emplace_child(alloc, pos, count, key, created_ptr, std::forward<_args_t>(args)...);
+		}
+	template <class _key_param_t, class... _args_t> _item_t* emplace_child(_alloc_t& alloc, uint16_t pos, uint16_t count, _key_param_t const& key, bool* created_ptr, _args_t&&... args)
+		{
 		for(uint16_t u=0; u<count; u++)
 			{
-			_item_t* got=this->m_children[pos+u]->get(std::forward<_item_t>(item), created_ptr, false);
-			if(got)
-				return got;
+			uint16_t child=(uint16_t)(pos+u);
+			_item_t* got=this->m_children[child]->emplace(alloc, key, created_ptr, false, std::forward<_args_t>(args)...);
+			if(!got)
+				continue;
+			if(*created_ptr)
+				{
+				this->inc_item_count(child);
+				update_bound(child);
+				}
+			return got;
 			}
 		return nullptr;
 		}
-	void update_bounds()noexcept
+	inline void update_bound(uint16_t position)noexcept
 		{
-		if(this->m_child_count==0)
-			{
-			m_first=nullptr;
-			m_last=nullptr;
+		auto child=this->m_children[position];
+		m_firsts[position].set(child->get_first());
+		m_lasts[position].set(child->get_last());
+		}
+	
+	// Common
+	_bound_t m_firsts[_group_size];
+	_bound_t m_lasts[_group_size];
+};
+
+
+//=======
+// Batch
+//=======
+
+// Items of a batch are sorted by reference.
+// Of equal keys the first is kept, or the last if they replace each other.
+
+template <class _traits_t>
+class index_batch
+{
+public:
+	// Using
+	using _item_t=typename _traits_t::item_t;
+	using _item_key_t=index_key<_item_t>;
+	using _order_t=index_order<typename _traits_t::compare_t>;
+	using _size_t=typename _traits_t::size_t;
+
+	// Con-/Destructors
+	index_batch(_item_t const* items, _size_t count, bool replace): m_count(0), m_items(nullptr)
+		{
+		if(!count)
 			return;
+		m_items=(_item_t const**)operator new(count*sizeof(_item_t const*));
+		for(_size_t u=0; u<count; u++)
+			m_items[u]=&items[u];
+		std::stable_sort(m_items, m_items+count, [](_item_t const* first, _item_t const* second)
+			{
+			return _order_t::compare(_item_key_t::get(*first), _item_key_t::get(*second))<0;
+			});
+		for(_size_t u=0; u<count; u++)
+			{
+			if(m_count>0&&_order_t::compare(_item_key_t::get(*m_items[m_count-1]), _item_key_t::get(*m_items[u]))==0)
+				{
+				if(replace)
+					m_items[m_count-1]=m_items[u];
+				continue;
+				}
+			m_items[m_count++]=m_items[u];
 			}
-		m_first=&this->m_children[0]->get_first();
-		m_last=&this->m_children[(uint16_t)(this->m_child_count-1)]->get_last();
 		}
-	
+	index_batch(index_batch const&)=delete;
+	~index_batch()noexcept
+		{
+		if(m_items)
+			operator delete(m_items);
+		}
+
+	// Access
+	inline _size_t get_count()const noexcept { return m_count; }
+	inline _item_t const* const* get_items()const noexcept { return m_items; }
+
+private:
+	// Common
+	_size_t m_count;
+	_item_t const** m_items;
+};
+
+
+//=========
+// Builder
+//=========
+
+// Bottom-up builder checking the order of the items.
+
+template <class _traits_t>
+class index_builder: public cluster_builder<_traits_t>
+{
+public:
+	// Using
+	using _base_t=cluster_builder<_traits_t>;
+	using _item_t=typename _traits_t::item_t;
+	using _item_key_t=index_key<_item_t>;
+	using _order_t=index_order<typename _traits_t::compare_t>;
+
+	// Con-/Destructors
+	using _base_t::_base_t;
+
+	// Modification
+	template <class... _args_t> _item_t& emplace(_args_t&&... args)
+		{
+		_item_t& item=_base_t::emplace(std::forward<_args_t>(args)...);
+		if(m_last)
+			{
+			if(_order_t::compare(_item_key_t::get(*m_last), _item_key_t::get(item))>=0)
+				throw std::invalid_argument("items not sorted");
+			}
+		m_last=&item;
+		return item;
+		}
+
+private:
 	// Common
-	_item_t const* m_first;
-	_item_t const* m_last;
+	_item_t const* m_last=nullptr;
 };
 
 
@@ -503,51 +876,55 @@ private:
 // Index
 //=======
 
-template <class _item_t, typename _size_t=uint32_t, uint16_t _group_size=10>
-class index: public cluster<index_traits<_item_t, _size_t, _group_size>>
+template <class _item_t, typename _size_t=uint32_t, uint16_t _group_size=10, class _alloc_t=cluster_pool, class _compare_t=index_compare>
+class index: public cluster<index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>>
 {
 public:
 	// Using
-	using _traits_t=index_traits<_item_t, _size_t, _group_size>;
+	using _traits_t=index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
 	using _base_t=cluster<_traits_t>;
+	using _builder_t=index_builder<_traits_t>;
 	using _group_t=typename _traits_t::group_t;
+	using _item_key_t=index_key<_item_t>;
 	using _parent_group_t=typename _traits_t::parent_group_t;
 	using iterator=typename _traits_t::iterator_t;
 	using const_iterator=typename _traits_t::const_iterator_t;
 
 	// Con-/Destructors
 	index()noexcept: _base_t(nullptr) {}
-	index(index const& index): _base_t(nullptr) { this->copy_from(index); }
-	index(index&& index)noexcept: _base_t(index.m_root) { index.m_root=nullptr; }
+	index(_alloc_t const& alloc): _base_t(nullptr, alloc) {}
+	index(index const& index): _base_t(nullptr, index.m_alloc) { this->copy_from(index); }
+	index(index&& index)noexcept: _base_t(std::move(index)) {}
+	template <class _it_t> index(_it_t first, _it_t last): _base_t(nullptr) { assign_sorted(first, last); }
 
 	// Access
 	inline _item_t& operator[](_size_t Position) { return _base_t::get_at(Position); }
 	inline _item_t const& operator[](_size_t Position)const { return _base_t::get_at(Position); }
-	inline const_iterator cfind(_item_t const& item, find_func func=find_func::equal)const
+	template <class _key_param_t> inline const_iterator cfind(_key_param_t const& key, find_func func=find_func::equal)const
 		{
 		const_iterator it(this);
-		it.find(item, func);
+		it.find(key, func);
 		return it;
 		}
-	bool contains(_item_t const& item)const noexcept
+	template <class _key_param_t> bool contains(_key_param_t const& key)const noexcept
 		{
 		auto root=this->m_root;
 		if(!root)
 			return false;
-		return root->get(item)!=nullptr;
+		return root->get(key)!=nullptr;
 		}
-	inline iterator find(_item_t const& item, find_func func=find_func::equal)
+	template <class _key_param_t> inline iterator find(_key_param_t const& key, find_func func=find_func::equal)
 		{
 		iterator it(this);
-		it.find(item, func);
+		it.find(key, func);
 		return it;
 		}
-	bool index_of(_item_t const& item, _size_t* pos_ptr)const noexcept
+	template <class _key_param_t> bool index_of(_key_param_t const& key, _size_t* pos_ptr)const noexcept
 		{
 		auto root=this->m_root;
 		if(!root)
 			return false;
-		return root->index_of(item, pos_ptr);
+		return root->index_of(key, pos_ptr);
 		}
 
 	// Modification
@@ -558,24 +935,78 @@ public:
 		}
 	template <class _item_param_t> bool add(_item_param_t const& item)
 		{
-		_item_t create(item);
+		// The item is only constructed if it is inserted.
 		bool created=false;
-		get_internal(std::forward<_item_t>(create), &created);
+		if constexpr(std::is_same<_item_param_t, _item_t>::value)
+			{
+			emplace_internal(_item_key_t::get(item), &created, item);
+			}
+		else
+			{
+			emplace_internal(item, &created, item);
+			}
+		return created;
+		}
+	inline _size_t add_many(_item_t const* items, _size_t count) { return add_many_internal(items, count); }
+	template <class _it_t> void assign_sorted(_it_t first, _it_t last)
+		{
+		_builder_t builder(this->m_alloc);
+		for(; first!=last; ++first)
+			builder.emplace(*first);
+		this->clear();
+		this->m_root=builder.finish();
+		}
+	template <class... _args_t> bool emplace(_args_t&&... args)
+		{
+		// The key is needed for the lookup, the item is moved if it is inserted.
+		_item_t create(std::forward<_args_t>(args)...);
+		bool created=false;
+		emplace_internal(_item_key_t::get(create), &created, std::move(create));
 		return created;
 		}
-	bool remove(_item_t const& item, _item_t* item_ptr=nullptr)noexcept
+	template <class _key_param_t> _size_t erase_range(_key_param_t const& first, _key_param_t const& last)
+		{
+		auto root=this->m_root;
+		if(!root)
+			return 0;
+		_size_t start=root->get_lower_bound(first);
+		_size_t end=root->get_lower_bound(last);
+		if(end<=start)
+			return 0;
+		this->remove_range(start, end-start);
+		return end-start;
+		}
+	void join(index&& index)
+		{
+		auto root=this->m_root;
+		auto tail_root=index.m_root;
+		if(root&&tail_root)
+			{
+			if(index_order<_compare_t>::compare(root->get_last(), tail_root->get_first())>=0)
+				throw std::invalid_argument("keys not ascending");
+			}
+		this->concat_from(index);
+		}
+	template <class _key_param_t> bool remove(_key_param_t const& key, _item_t* item_ptr=nullptr)
 		{
+		unshare_key(key);
 		auto root=this->m_root;
 		if(!root)
 			return false;
-		return root->remove(item, item_ptr);
+		if(!root->remove(this->m_alloc, key, item_ptr))
+			return false;
+		this->drop_root();
+		return true;
 		}
-	template <class _item_param_t> bool set(_item_param_t const& item)
+	template <class _item_param_t> inline bool set(_item_param_t const& item) { return add(item); }
+	inline _size_t set_many(_item_t const* items, _size_t count) { return add_many_internal(items, count); }
+	template <class _key_param_t> index split(_key_param_t const& key)
 		{
-		_item_t create(item);
-		bool created=false;
-		get_internal(std::forward<_item_t>(create), &created);
-		return created;
+		_size_t position=0;
+		auto root=this->m_root;
+		if(root)
+			position=root->get_lower_bound(key);
+		return this->split_at(position);
 		}
 
 protected:
@@ -584,14 +1015,50 @@ protected:
 
 private:
 	// Common
-	_item_t* get_internal(_item_t&& item, bool* created_ptr)
+	_size_t add_many_internal(_item_t const* items, _size_t count)
+		{
+		index_batch<_traits_t> batch(items, count, false);
+		auto sorted=batch.get_items();
+		count=batch.get_count();
+		this->unshare_root();
+		_size_t created=0;
+		_size_t pos=0;
+		while(pos<count)
+			{
+			auto root=this->create_root();
+			_size_t added=root->add_many(this->m_alloc, &sorted[pos], count-pos, false, &created);
+			if(added)
+				{
+				pos+=added;
+				continue;
+				}
+			bool item_created=false;
+			_item_t const& item=*sorted[pos];
+			emplace_internal(_item_key_t::get(item), &item_created, item);
+			if(item_created)
+				created++;
+			pos++;
+			}
+		return created;
+		}
+	template <class _key_param_t, class... _args_t> _item_t* emplace_internal(_key_param_t const& key, bool* created, _args_t&&... args)
 		{
+		this->unshare_root();
 		auto root=this->create_root();
-		_item_t* got=root->get(std::forward<_item_t>(item), created_ptr, false);
+		_item_t* got=root->emplace(this->m_alloc, key, created, false, std::forward<_args_t>(args)...);
 		if(got)
 			return got;
 		root=this->lift_root();
-		return root->get(std::forward<_item_t>(item), created_ptr, true);
+		return root->emplace(this->m_alloc, key, created, true, std::forward<_args_t>(args)...);
+		}
+	template <class _key_param_t> void unshare_key(_key_param_t const& key)
+		{
+		// Groups are only combined on the path when removing.
+		auto root=this->m_root;
+		if(!this->m_shared||!root)
+			return;
+		_size_t position=root->get_lower_bound(key);
+		this->unshare(position, position);
 		}
 };
 
@@ -616,7 +1083,7 @@ public:
 	using _base_t::_base_t;
 
 	// Navigation
-	bool find(_item_t const& item, find_func func=find_func::equal)
+	template <class _key_param_t> bool find(_key_param_t const& key, find_func func=find_func::equal)
 		{
 		auto group=this->m_cluster->get_root();
 		if(!group)
@@ -631,7 +1098,7 @@ public:
 		bool exists=false;
 		while(group)
 			{
-			uint16_t group_pos=group->find(item, &exists, func);
+			uint16_t group_pos=group->find(key, &exists, func);
 			if(group_pos==_group_size)
 				break;
 			it_ptr->group=group;
@@ -641,8 +1108,7 @@ public:
 				{
 				auto parent_group=(_parent_group_t*)group;
 				group=parent_group->get_child(group_pos);
-				for(uint16_t u=0; u<group_pos; u++)
-					this->m_position+=parent_group->get_child(u)->get_item_count();
+				this->m_position+=parent_group->get_offset(group_pos);
 				continue;
 				}
 			auto item_group=(_item_group_t*)group;
@@ -0,0 +1,336 @@
+//==================
+// index_search.hpp
+//==================
+
+// Search of sorted items in an item-group.
+// Keys are compared once per step with a three-way comparison.
+// Arithmetic keys are counted with SIMD-instructions if available.
+
+// Copyright 2026, Sven Bieg (svenbieg@outlook.de)
+// https://github.com/svenbieg/Clusters
+
+#pragma once
+
+
+//=======
+// Using
+//=======
+
+#include <stdint.h>
+#include <type_traits>
+
+#if defined(__cpp_impl_three_way_comparison)&&defined(__cpp_concepts)
+#include <compare>
+#define CLUSTERS_THREE_WAY
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CLUSTERS_SEARCH_AVX2
+#elif defined(__SSE2__)||defined(_M_X64)||(defined(_M_IX86_FP)&&_M_IX86_FP>=2)
+#include <emmintrin.h>
+#define CLUSTERS_SEARCH_SSE2
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define CLUSTERS_SEARCH_SSE42
+#endif
+#endif
+
+
+//===========
+// Namespace
+//===========
+
+namespace Collections {
+
+
+//=====
+// Key
+//=====
+
+// Items are compared by their keys.
+
+template <class _item_t>
+struct index_key
+{
+using key_t=_item_t;
+static inline key_t const& get(_item_t const& item)noexcept { return item; }
+};
+
+
+//=========
+// Compare
+//=========
+
+// Default order of the keys, operator<=> is used if available.
+
+struct index_compare
+{
+template <class _first_t, class _second_t> inline auto operator()(_first_t const& first, _second_t const& second)const
+	{
+	#ifdef CLUSTERS_THREE_WAY
+	if constexpr(requires { first<=>second; })
+		{
+		return first<=>second;
+		}
+	else
+	#endif
+		{
+		if(first<second)
+			return -1;
+		return (second<first)? 1: 0;
+		}
+	}
+};
+
+// Comparators can return an ordering, an integer or a bool like std::less.
+
+template <class _compare_t>
+struct index_order
+{
+template <class _first_t, class _second_t> static inline int compare(_first_t const& first, _second_t const& second)
+	{
+	_compare_t cmp;
+	auto order=cmp(first, second);
+	if constexpr(std::is_same<decltype(order), bool>::value)
+		{
+		if(order)
+			return -1;
+		return cmp(second, first)? 1: 0;
+		}
+	else
+		{
+		if(order<0)
+			return -1;
+		return (order>0)? 1: 0;
+		}
+	}
+};
+
+
+//========
+// Search
+//========
+
+// The key can be of any type comparable with the keys of the items.
+
+template <class _item_t, class _compare_t=index_compare,
+	bool _simd=std::is_arithmetic<_item_t>::value&&sizeof(_item_t)<=sizeof(int64_t)&&std::is_same<_compare_t, index_compare>::value>
+class index_search
+{
+public:
+	// Using
+	using _item_key_t=index_key<_item_t>;
+	using _key_t=typename _item_key_t::key_t;
+	using _order_t=index_order<_compare_t>;
+
+	// Access
+	template <class _key_param_t> static uint16_t get_item_pos(_item_t const* items, uint16_t count, _key_param_t const& key, bool* exists)noexcept
+		{
+		uint16_t start=0;
+		uint16_t end=count;
+		while(start<end)
+			{
+			uint16_t pos=(uint16_t)(start+(end-start)/2);
+			int cmp=_order_t::compare(_item_key_t::get(items[pos]), key);
+			if(cmp>0)
+				{
+				end=pos;
+				continue;
+				}
+			if(cmp<0)
+				{
+				start=(uint16_t)(pos+1);
+				continue;
+				}
+			*exists=true;
+			return pos;
+			}
+		return start;
+		}
+};
+
+
+//===================
+// Search Arithmetic
+//===================
+
+// Keys of other types are converted if the comparison would convert them too.
+
+template <class _item_t, class _compare_t>
+class index_search<_item_t, _compare_t, true>: public index_search<_item_t, _compare_t, false>
+{
+public:
+	// Using
+	using _base_t=index_search<_item_t, _compare_t, false>;
+
+	// Access
+	template <class _key_param_t> static inline uint16_t get_item_pos(_item_t const* items, uint16_t count, _key_param_t const& key, bool* exists)noexcept
+		{
+		if constexpr(std::is_arithmetic<_key_param_t>::value)
+			{
+			if constexpr(std::is_same<typename std::common_type<_item_t, _key_param_t>::type, _item_t>::value)
+				return get_item_pos(items, count, (_item_t)key, exists);
+			}
+		return _base_t::get_item_pos(items, count, key, exists);
+		}
+	static uint16_t get_item_pos(_item_t const* items, uint16_t count, _item_t item, bool* exists)noexcept
+		{
+		uint16_t start=0;
+		uint16_t end=count;
+		while(end-start>_window)
+			{
+			uint16_t pos=(uint16_t)(start+(end-start)/2);
+			if(items[pos]<item)
+				{
+				start=(uint16_t)(pos+1);
+				}
+			else
+				{
+				end=pos;
+				}
+			}
+		uint16_t pos=(uint16_t)(start+count_below(&items[start], (uint16_t)(end-start), item));
+		if(pos<count&&items[pos]==item)
+			*exists=true;
+		return pos;
+		}
+
+private:
+	// Settings
+	static const uint16_t _window=32;
+
+	// Common
+	static inline uint16_t count_bits(uint32_t mask)noexcept
+		{
+		uint16_t count=0;
+		for(; mask; mask&=mask-1)
+			count++;
+		return count;
+		}
+	static uint16_t count_below(_item_t const* items, uint16_t count, _item_t item)noexcept
+		{
+		uint16_t pos=0;
+		uint16_t below=0;
+		// Floating points other than float and double are counted one by one.
+		if constexpr(std::is_same<_item_t, float>::value||std::is_same<_item_t, double>::value)
+			{
+			below=count_below_float(items, count, item, &pos);
+			}
+		else if constexpr(std::is_integral<_item_t>::value&&(sizeof(_item_t)==sizeof(int32_t)||sizeof(_item_t)==sizeof(int64_t)))
+			{
+			below=count_below_int(items, count, item, &pos);
+			}
+		for(; pos<count; pos++)
+			below=(uint16_t)(below+(items[pos]<item));
+		return below;
+		}
+	static uint16_t count_below_float(_item_t const* items, uint16_t count, _item_t item, uint16_t* pos_ptr)noexcept
+		{
+		uint16_t below=0;
+		uint16_t pos=0;
+		#if defined(CLUSTERS_SEARCH_AVX2)
+		if constexpr(sizeof(_item_t)==sizeof(float))
+			{
+			__m256 key=_mm256_set1_ps(item);
+			for(; pos+8<=count; pos+=8)
+				{
+				__m256 cmp=_mm256_cmp_ps(_mm256_loadu_ps(&items[pos]), key, _CMP_LT_OQ);
+				below=(uint16_t)(below+count_bits((uint32_t)_mm256_movemask_ps(cmp)));
+				}
+			}
+		else
+			{
+			__m256d key=_mm256_set1_pd(item);
+			for(; pos+4<=count; pos+=4)
+				{
+				__m256d cmp=_mm256_cmp_pd(_mm256_loadu_pd(&items[pos]), key, _CMP_LT_OQ);
+				below=(uint16_t)(below+count_bits((uint32_t)_mm256_movemask_pd(cmp)));
+				}
+			}
+		#elif defined(CLUSTERS_SEARCH_SSE2)
+		if constexpr(sizeof(_item_t)==sizeof(float))
+			{
+			__m128 key=_mm_set1_ps(item);
+			for(; pos+4<=count; pos+=4)
+				{
+				__m128 cmp=_mm_cmplt_ps(_mm_loadu_ps(&items[pos]), key);
+				below=(uint16_t)(below+count_bits((uint32_t)_mm_movemask_ps(cmp)));
+				}
+			}
+		else
+			{
+			__m128d key=_mm_set1_pd(item);
+			for(; pos+2<=count; pos+=2)
+				{
+				__m128d cmp=_mm_cmplt_pd(_mm_loadu_pd(&items[pos]), key);
+				below=(uint16_t)(below+count_bits((uint32_t)_mm_movemask_pd(cmp)));
+				}
+			}
+		#endif
+		*pos_ptr=pos;
+		return below;
+		}
+	static uint16_t count_below_int(_item_t const* items, uint16_t count, _item_t item, uint16_t* pos_ptr)noexcept
+		{
+		uint16_t below=0;
+		uint16_t pos=0;
+		#if defined(CLUSTERS_SEARCH_AVX2)||defined(CLUSTERS_SEARCH_SSE2)
+		// Unsigned keys are compared signed with flipped sign-bits.
+		const bool flip=std::is_unsigned<_item_t>::value;
+		#endif
+		#if defined(CLUSTERS_SEARCH_AVX2)
+		if constexpr(sizeof(_item_t)==sizeof(int32_t))
+			{
+			__m256i sign=_mm256_set1_epi32(flip? INT32_MIN: 0);
+			__m256i key=_mm256_xor_si256(_mm256_set1_epi32((int32_t)item), sign);
+			for(; pos+8<=count; pos+=8)
+				{
+				__m256i value=_mm256_xor_si256(_mm256_loadu_si256((__m256i const*)&items[pos]), sign);
+				__m256i cmp=_mm256_cmpgt_epi32(key, value);
+				below=(uint16_t)(below+count_bits((uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(cmp))));
+				}
+			}
+		else
+			{
+			__m256i sign=_mm256_set1_epi64x(flip? INT64_MIN: 0);
+			__m256i key=_mm256_xor_si256(_mm256_set1_epi64x((int64_t)item), sign);
+			for(; pos+4<=count; pos+=4)
+				{
+				__m256i value=_mm256_xor_si256(_mm256_loadu_si256((__m256i const*)&items[pos]), sign);
+				__m256i cmp=_mm256_cmpgt_epi64(key, value);
+				below=(uint16_t)(below+count_bits((uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(cmp))));
+				}
+			}
+		#elif defined(CLUSTERS_SEARCH_SSE2)
+		if constexpr(sizeof(_item_t)==sizeof(int32_t))
+			{
+			__m128i sign=_mm_set1_epi32(flip? INT32_MIN: 0);
+			__m128i key=_mm_xor_si128(_mm_set1_epi32((int32_t)item), sign);
+			for(; pos+4<=count; pos+=4)
+				{
+				__m128i value=_mm_xor_si128(_mm_loadu_si128((__m128i const*)&items[pos]), sign);
+				__m128i cmp=_mm_cmpgt_epi32(key, value);
+				below=(uint16_t)(below+count_bits((uint32_t)_mm_movemask_ps(_mm_castsi128_ps(cmp))));
+				}
+			}
+		#if defined(CLUSTERS_SEARCH_SSE42)
+		else
+			{
+			__m128i sign=_mm_set1_epi64x(flip? INT64_MIN: 0);
+			__m128i key=_mm_xor_si128(_mm_set1_epi64x((int64_t)item), sign);
+			for(; pos+2<=count; pos+=2)
+				{
+				__m128i value=_mm_xor_si128(_mm_loadu_si128((__m128i const*)&items[pos]), sign);
+				__m128i cmp=_mm_cmpgt_epi64(key, value);
+				below=(uint16_t)(below+count_bits((uint32_t)_mm_movemask_pd(_mm_castsi128_pd(cmp))));
+				}
+			}
+		#endif
+		#endif
+		*pos_ptr=pos;
+		return below;
+		}
+};
+
+}
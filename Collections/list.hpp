@@ -29,20 +29,21 @@ namespace Collections {
 // Forward-Declarations
 //======================
 
-template <class _item_t, typename _size_t, uint16_t _group_size> class list;
-template <class _item_t, typename _size_t, uint16_t _group_size> class list_group;
-template <class _item_t, typename _size_t, uint16_t _group_size> class list_item_group;
-template <class _item_t, typename _size_t, uint16_t _group_size> class list_parent_group;
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t> class list;
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t> class list_group;
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t> class list_item_group;
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t> class list_parent_group;
 template <class _traits_t, bool _is_const> class shared_cluster_iterator;
 
-template <class _item_t, typename _size_t, uint16_t _group_size>
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t>
 struct list_traits
 {
+using alloc_t=_alloc_t;
 using item_t=_item_t;
-using group_t=list_group<_item_t, _size_t, _group_size>;
-using item_group_t=list_item_group<_item_t, _size_t, _group_size>;
-using parent_group_t=list_parent_group<_item_t, _size_t, _group_size>;
-using cluster_t=list<_item_t, _size_t, _group_size>;
+using group_t=list_group<_item_t, _size_t, _group_size, _alloc_t>;
+using item_group_t=list_item_group<_item_t, _size_t, _group_size, _alloc_t>;
+using parent_group_t=list_parent_group<_item_t, _size_t, _group_size, _alloc_t>;
+using cluster_t=list<_item_t, _size_t, _group_size, _alloc_t>;
 using iterator_t=cluster_iterator<list_traits, false>;
 using const_iterator_t=cluster_iterator<list_traits, true>;
 using shared_iterator_t=shared_cluster_iterator<list_traits, false>;
@@ -56,18 +57,53 @@ static const uint16_t group_size=_group_size;
 // Group
 //=======
 
-template <class _item_t, typename _size_t, uint16_t _group_size>
-class list_group: public cluster_group<list_traits<_item_t, _size_t, _group_size>>
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t>
+class list_group: public cluster_group<list_traits<_item_t, _size_t, _group_size, _alloc_t>>
 {
 public:
+	// Using
+	using _traits_t=list_traits<_item_t, _size_t, _group_size, _alloc_t>;
+	using _base_t=cluster_group<_traits_t>;
+	using _item_group_t=typename _traits_t::item_group_t;
+	using _parent_group_t=typename _traits_t::parent_group_t;
+
 	// Access
-	virtual _size_t get_many(_size_t position, _item_t* items, _size_t count)const=0;
+	_size_t get_many(_size_t position, _item_t* items, _size_t count)const
+		{
+		if(this->m_level==0)
+			return ((_item_group_t const*)this)->get_many(position, items, count);
+		return ((_parent_group_t const*)this)->get_many(position, items, count);
+		}
 
 	// Modification
-	virtual _item_t* append(_item_t const& item, bool again)=0;
-	virtual _size_t append(_item_t const* append, _size_t count)noexcept=0;
-	virtual _item_t* insert_at(_size_t position, _item_t const& item, bool again)=0;
-	virtual _size_t set_many(_size_t position, _item_t const* many, _size_t count)=0;
+	_item_t* append(_alloc_t& alloc, _item_t const& item, bool again)
+		{
+		if(this->m_level==0)
+			return ((_item_group_t*)this)->append(alloc, item, again);
+		return ((_parent_group_t*)this)->append(alloc, item, again);
+		}
+	_size_t append(_alloc_t& alloc, _item_t const* append, _size_t count)
+		{
+		if(this->m_level==0)
+			return ((_item_group_t*)this)->append(alloc, append, count);
+		return ((_parent_group_t*)this)->append(alloc, append, count);
+		}
+	template <class... _args_t> _item_t* emplace_at(_alloc_t& alloc, _size_t position, bool again, _args_t&&... args)
+		{
+		if(this->m_level==0)
+			return ((_item_group_t*)this)->emplace_at(alloc, position, again, std::forward<_args_t>(args)...);
+		return ((_parent_group_t*)this)->emplace_at(alloc, position, again, std::forward<_args_t>(args)...);
+		}
+	_size_t set_many(_alloc_t& alloc, _size_t position, _item_t const* many, _size_t count)
+		{
+		if(this->m_level==0)
+			return ((_item_group_t*)this)->set_many(alloc, position, many, count);
+		return ((_parent_group_t*)this)->set_many(alloc, position, many, count);
+		}
+
+protected:
+	// Con-/Destructors
+	using _base_t::_base_t;
 };
 
 
@@ -75,12 +111,12 @@ public:
 // Item-Group
 //============
 
-template <class _item_t, typename _size_t, uint16_t _group_size>
-class list_item_group: public cluster_item_group<list_traits<_item_t, _size_t, _group_size>>
+template <class _item_t, typename _size_t, uint16_t _group_size, class _alloc_t>
+class list_item_group: public cluster_item_group<list_traits<_item_t, _size_t, _group_size, _alloc_t>>
 {
 public:
 	// Using
-	using _traits_t=list_traits<_item_t, _size_t, _group_size>;
+	using _traits_t=list_traits<_item_t, _size_t, _group_size, _alloc_t>;
 	using _base_t=cluster_item_group<_traits_t>;
 	using _group_t=typename _traits_t::group_t;
 	using _item_group_t=typename _traits_t::item_group_t;
@@ -89,7 +125,7 @@ public:
 	using _base_t::_base_t;
 
 	// Access
-	_size_t get_many(_size_t position, _item_t* many, _size_t count)const override
+	_size_t get_many(_size_t position, _item_t* many, _size_t count)const
 		{
 		uint16_t item_count=this->m_item_count;
 		if(position>=item_count)
@@ -99,17 +135,16 @@ public:
 		uint16_t copy=(uint16_t)(item_count-pos);
 		if(copy>count)
 			copy=(uint16_t)count;
-		for(uint16_t u=0; u<copy; u++)
-			many[u]=items[pos+u];
+		std::copy(&items[pos], &items[pos+copy], many);
 		return copy;
 		}
 
 	// Modification
-	inline _item_t* append(_item_t const& item, bool again)override
+	inline _item_t* append(_alloc_t&, _item_t const& item, bool)
 		{
 		return this->insert_item(this->m_item_count, item);
 		}
-	_size_t append(_item_t const* append, _size_t count)noexcept override
+	_size_t append(_alloc_t&, _item_t const* append, _size_t count)
 		{
 		uint16_t item_count=this->m_item_count;
 		if(item_count==_group_size)
@@ -119,14 +154,14 @@ public:
 			copy=(uint16_t)count;
 		return this->insert_items(item_count, append, copy);
 		}
-	_item_t* insert_at(_size_t position, _item_t const& item, bool again)override
+	template <class... _args_t> _item_t* emplace_at(_alloc_t&, _size_t position, bool, _args_t&&... args)
 		{
 		if(position>this->m_item_count)
 			throw std::out_of_range(nullptr);
 		uint16_t pos=(uint16_t)position;
-		return this->insert_item(pos, item);
+		return this->emplace_item(pos, std::forward<_args_t>(args)...);
 		}
-	_size_t set_many(_size_t position, _item_t const* many, _size_t count)override
+	_size_t set_many(_alloc_t&, _size_t position, _item_t const* many, _size_t count)
 		{
 		uint16_t item_count=this->m_item_count;
 		if(position>item_count)
@@ -136,8 +171,7 @@ public:
 		if(copy>count)
 			copy=(uint16_t)count;
 		_item_t* items=this->get_items();
-		for(uint16_t u=0; u<copy; u++)
-			items[position+u]=many[u];
+		std::copy(many, many+copy, &items[pos]);
 		return copy;
 		}
 };
@@ -147,12 +181,13 @@ public:
 // Parent-Group
 //==============
 
-template <typename _item_t, typename _size_t, uint16_t _group_size>
-class list_parent_group: public cluster_parent_group<list_traits<_item_t, _size_t, _group_size>>
+template <typename _item_t, typename _size_t, uint16_t _group_size, class _alloc_t>
+class list_parent_group: public cluster_parent_group<list_traits<_item_t, _size_t, _group_size, _alloc_t>>
 {
 public:
 	// Using
-	using _traits_t=list_traits<_item_t, _size_t, _group_size>;
+	using _traits_t=list_traits<_item_t, _size_t, _group_size, _alloc_t>;
+	using _allocator_t=cluster_allocator<_traits_t>;
 	using _base_t=cluster_parent_group<_traits_t>;
 	using _group_t=typename _traits_t::group_t;
 	using _item_group_t=typename _traits_t::item_group_t;
@@ -162,9 +197,9 @@ public:
 	using _base_t::_base_t;
 
 	// Access
-	_size_t get_many(_size_t position, _item_t* items, _size_t count)const override
+	_size_t get_many(_size_t position, _item_t* items, _size_t count)const
 		{
-		if(position>=this->m_item_count)
+		if(position>=this->get_item_count())
 			throw std::out_of_range(nullptr);
 		uint16_t group=this->get_group(&position);
 		_size_t pos=0;
@@ -183,52 +218,46 @@ public:
 		}
 
 	// Modification
-	_item_t* append(_item_t const& item, bool again)override
+	_item_t* append(_alloc_t& alloc, _item_t const& item, bool again)
 		{
+		this->unshare_children(alloc);
 		if(!again)
 			{
 			uint16_t group=(uint16_t)(this->m_child_count-1);
-			_item_t* appended=this->m_children[group]->append(item, false);
+			_item_t* appended=this->m_children[group]->append(alloc, item, false);
 			if(appended)
 				{
-				this->m_item_count++;
+				this->inc_item_count(group);
 				return appended;
 				}
 			uint16_t empty=this->get_nearest_space(group);
 			if(empty<this->m_child_count)
 				{
 				this->move_emtpy_slot(empty, group);
-				appended=this->m_children[group]->append(item, false);
-				this->m_item_count++;
+				appended=this->m_children[group]->append(alloc, item, false);
+				this->inc_item_count(group);
 				return appended;
 				}
 			}
 		uint16_t group=this->m_child_count;
 		if(group==_group_size)
 			return nullptr;
-		uint16_t level=this->m_level;
-		if(level>1)
-			{
-			this->m_children[group]=new _parent_group_t(level-1);
-			}
-		else
-			{
-			this->m_children[group]=new _item_group_t();
-			}
-		this->m_child_count++;
-		_item_t* appended=this->m_children[group]->append(item, true);
-		this->m_item_count++;
+		auto child=_allocator_t::create_group(alloc, (uint16_t)(this->m_level-1));
+		this->insert_groups(group, &child, 1);
+		_item_t* appended=child->append(alloc, item, true);
+		this->inc_item_count(group);
 		return appended;
 		}
-	_size_t append(_item_t const* append, _size_t count)noexcept override
+	_size_t append(_alloc_t& alloc, _item_t const* append, _size_t count)
 		{
+		this->unshare_children(alloc);
 		_size_t pos=0;
 		uint16_t child_count=this->m_child_count;
 		if(child_count>0)
 			{
 			auto child=this->get_child(child_count-1);
-			pos+=child->append(append, count);
-			this->m_item_count+=pos;
+			pos+=child->append(alloc, append, count);
+			this->inc_item_count((uint16_t)(child_count-1), pos);
 			if(pos==count)
 				return count;
 			}
@@ -238,17 +267,17 @@ public:
 			for(; last<child_count; last++)
 				{
 				auto child=this->get_child(last);
-				auto written=child->append(&append[pos], count-pos);
+				auto written=child->append(alloc, &append[pos], count-pos);
 				if(!written)
 					continue;
-				this->m_item_count+=written;
+				this->inc_item_count(last, written);
 				pos+=written;
 				if(pos==count)
 					break;
 				}
 			if(pos==count)
 				{
-				free_children();
+				free_children(alloc);
 				return count;
 				}
 			}
@@ -257,29 +286,19 @@ public:
 			child_count=this->m_child_count;
 			if(child_count==_group_size)
 				break;
-			uint16_t level=this->m_level;
-			_group_t* group=nullptr;
-			if(level==1)
-				{
-				group=new _item_group_t();
-				this->m_children[child_count]=group;
-				}
-			else
-				{
-				group=new _parent_group_t((uint16_t)(level-1));
-				this->m_children[child_count]=group;
-				}
-			this->m_child_count++;
-			auto written=group->append(&append[pos], count-pos);
-			this->m_item_count+=written;
+			auto group=_allocator_t::create_group(alloc, (uint16_t)(this->m_level-1));
+			this->insert_groups(child_count, &group, 1);
+			auto written=group->append(alloc, &append[pos], count-pos);
+			this->inc_item_count(child_count, written);
 			pos+=written;
 			}
 		return pos;
 		}
-	_item_t* insert_at(_size_t position, _item_t const& item, bool again)override
+	template <class... _args_t> _item_t* emplace_at(_alloc_t& alloc, _size_t position, bool again, _args_t&&... args)
 		{
-		if(position>this->m_item_count)
+		if(position>this->get_item_count())
 			throw std::out_of_range(nullptr);
+		this->unshare_children(alloc);
 		_size_t pos=position;
 		uint16_t group=0;
 		uint16_t ins_count=get_insert_pos(&pos, &group);
@@ -289,10 +308,10 @@ public:
 			for(uint16_t u=0; u<ins_count; u++)
 				{
 				auto child=this->get_child(group+u);
-				_item_t* inserted=child->insert_at(at, item, false);
+				_item_t* inserted=child->emplace_at(alloc, at, false, std::forward<_args_t>(args)...);
 				if(inserted)
 					{
-					this->m_item_count++;
+					this->inc_item_count((uint16_t)(group+u));
 					return inserted;
 					}
 				at=0;
@@ -305,17 +324,17 @@ public:
 				for(uint16_t u=0; u<ins_count; u++)
 					{
 					auto child=this->get_child(group+u);
-					_item_t* inserted=child->insert_at(at, item, false);
+					_item_t* inserted=child->emplace_at(alloc, at, false, std::forward<_args_t>(args)...);
 					if(inserted)
 						{
-						this->m_item_count++;
+						this->inc_item_count((uint16_t)(group+u));
 						return inserted;
 						}
 					at=0;
 					}
 				}
 			}
-		if(!this->split_child(group))
+		if(!this->split_child(alloc, group))
 			return nullptr;
 		_size_t count=this->m_children[group]->get_item_count();
 		if(pos>=count)
@@ -324,22 +343,24 @@ public:
 			pos-=count;
 			}
 		auto child=this->get_child(group);
-		_item_t* inserted=child->insert_at(pos, item, true);
-		this->m_item_count++;
+		_item_t* inserted=child->emplace_at(alloc, pos, true, std::forward<_args_t>(args)...);
+		this->inc_item_count(group);
 		return inserted;
 		}
-	_size_t set_many(_size_t position, _item_t const* many, _size_t count)override
+	_size_t set_many(_alloc_t& alloc, _size_t position, _item_t const* many, _size_t count)
 		{
-		if(position>this->m_item_count)
+		_size_t item_count=this->get_item_count();
+		if(position>item_count)
 			throw std::out_of_range(nullptr);
-		if(position==this->m_item_count)
-			return append(many, count);
+		if(position==item_count)
+			return 0;
+		this->unshare_children(alloc);
 		uint16_t group=this->get_group(&position);
 		_size_t pos=0;
 		while(pos<count)
 			{
 			auto child=this->get_child(group);
-			pos+=child->set_many(position, &many[pos], count-pos);
+			pos+=child->set_many(alloc, position, &many[pos], count-pos);
 			if(pos==count)
 				break;
 			group++;
@@ -347,8 +368,6 @@ public:
 				break;
 			position=0;
 			}
-		if(pos<count)
-			pos+=append(&many[pos], count-pos);
 		return pos;
 		}
 
@@ -358,31 +377,38 @@ private:
 		{
 		uint16_t child_count=this->m_child_count;
 		_size_t pos=*position;
-		for(uint16_t u=0; u<child_count; u++)
+		uint16_t start=0;
+		uint16_t end=child_count;
+		while(start<end)
 			{
-			_size_t count=this->m_children[u]->get_item_count();
-			if(pos<=count)
+			uint16_t u=(uint16_t)(start+(end-start)/2);
+			if(this->m_item_counts[u]<pos)
 				{
-				*group=u;
-				*position=pos;
-				if(pos==count&&u+1<child_count)
-					return 2;
-				return 1;
+				start=(uint16_t)(u+1);
+				}
+			else
+				{
+				end=u;
 				}
-			pos-=count;
 			}
-		return 0;
+		if(start==child_count)
+			return 0;
+		*group=start;
+		*position=pos-this->get_offset(start);
+		if(pos==this->m_item_counts[start]&&start+1<child_count)
+			return 2;
+		return 1;
 		}
 
 	// Modification
-	void free_children()noexcept
+	void free_children(_alloc_t& alloc)noexcept
 		{
 		for(uint16_t u=this->m_child_count; u>0; u--)
 			{
 			uint16_t pos=u-1;
 			if(this->m_children[pos]->get_child_count()>0)
 				break;
-			this->remove_group(pos);
+			this->remove_group(alloc, pos);
 			}
 		}
 	uint16_t minimize()noexcept
@@ -410,6 +436,12 @@ private:
 					break;
 				}
 			}
+		// The children behind the first one with space are empty now.
+		for(dst=0; dst+1<child_count; dst++)
+			{
+			if(this->m_children[dst]->get_child_count()<_group_size)
+				break;
+			}
 		return dst;
 		}
 };
@@ -419,19 +451,20 @@ private:
 // List
 //======
 
-template <typename _item_t, typename _size_t=uint32_t, uint16_t _group_size=10>
-class list: public cluster<list_traits<_item_t, _size_t, _group_size>>
+template <typename _item_t, typename _size_t=uint32_t, uint16_t _group_size=10, class _alloc_t=cluster_pool>
+class list: public cluster<list_traits<_item_t, _size_t, _group_size, _alloc_t>>
 {
 public:
 	// Using
-	using _traits_t=list_traits<_item_t, _size_t, _group_size>;
+	using _traits_t=list_traits<_item_t, _size_t, _group_size, _alloc_t>;
 	using _base_t=cluster<_traits_t>;
 	using _group_t=typename _traits_t::group_t;
 
 	// Con-/Destructors
 	list()noexcept: _base_t(nullptr) {}
-	list(list const& list): _base_t(nullptr) { this->copy_from(list); }
-	list(list&& list)noexcept: _base_t(list.m_root) { list.m_root=nullptr; }
+	list(_alloc_t const& alloc): _base_t(nullptr, alloc) {}
+	list(list const& list): _base_t(nullptr, list.m_alloc) { this->copy_from(list); }
+	list(list&& list)noexcept: _base_t(std::move(list)) {}
 
 	// Access
 	inline _item_t& operator[](_size_t position) { return this->get_at(position); }
@@ -476,27 +509,29 @@ public:
 	inline _item_t& append() { return append(_item_t()); }
 	_item_t& append(_item_t const& item)
 		{
+		this->unshare_root();
 		auto root=this->create_root();
-		_item_t* appended=root->append(item, false);
+		_item_t* appended=root->append(this->m_alloc, item, false);
 		if(appended)
 			return *appended;
 		root=this->lift_root();
-		return *root->append(item, true);
+		return *root->append(this->m_alloc, item, true);
 		}
 	void append(_item_t const* items, _size_t count)
 		{
+		this->unshare_root();
 		auto root=this->create_root();
 		_size_t pos=0;
 		while(1)
 			{
-			pos+=root->append(&items[pos], count-pos);
+			pos+=root->append(this->m_alloc, &items[pos], count-pos);
 			if(pos==count)
 				break;
 			root=this->lift_root();
 			}
 		}
-	inline _item_t& insert_at(_size_t position) { return insert_at(position, _item_t()); }
-	_item_t& insert_at(_size_t position, _item_t const& item)
+	inline void concat(list&& list) { this->concat_from(list); }
+	template <class... _args_t> _item_t& emplace_at(_size_t position, _args_t&&... args)
 		{
 		auto root=this->m_root;
 		if(!root)
@@ -505,23 +540,23 @@ public:
 				throw std::out_of_range(nullptr);
 			root=this->create_root();
 			}
-		_item_t* inserted=root->insert_at(position, item, false);
+		this->unshare_root();
+		root=this->m_root;
+		_item_t* inserted=root->emplace_at(this->m_alloc, position, false, std::forward<_args_t>(args)...);
 		if(inserted)
 			return *inserted;
 		root=this->lift_root();
-		return *root->insert_at(position, item, true);
+		return *root->emplace_at(this->m_alloc, position, true, std::forward<_args_t>(args)...);
 		}
+	inline _item_t& insert_at(_size_t position) { return emplace_at(position); }
+	inline _item_t& insert_at(_size_t position, _item_t const& item) { return emplace_at(position, item); }
 	bool remove(_item_t const& item)
 		{
-		for(auto it=this->begin(); it.has_current(); it.move_next())
-			{
-			if(*it==item)
-				{
-				it.remove_current();
-				return true;
-				}
-			}
-		return false;
+		_size_t position=0;
+		if(!index_of(item, &position))
+			return false;
+		this->remove_at(position);
+		return true;
 		}
 	bool set_at(_size_t position, _item_t const& item)
 		{
@@ -533,20 +568,17 @@ public:
 		}
 	_size_t set_many(_size_t position, _item_t const* items, _size_t count)
 		{
-		auto root=this->m_root;
-		if(!root)
-			{
-			if(position>0)
-				throw std::out_of_range(nullptr);
-			root=this->create_root();
-			}
-		for(_size_t pos=0; pos<count; )
+		if(position>this->get_count())
+			throw std::out_of_range(nullptr);
+		// Items are overwritten up to the end, the rest is appended.
+		_size_t pos=0;
+		if(position<this->get_count()&&count>0)
 			{
-			pos+=root->set_many(position+pos, &items[pos], count-pos);
-			if(pos==count)
-				break;
-			root=this->lift_root();
+			this->unshare_root();
+			pos=this->m_root->set_many(this->m_alloc, position, items, count);
 			}
+		if(pos<count)
+			append(&items[pos], count-pos);
 		return count;
 		}
 
@@ -29,20 +29,22 @@ namespace Collections {
 // Forward-Declarations
 //======================
 
-template <class _key_t, class _value_t, typename _size_t, uint16_t _group_size> class map;
+template <class _key_t, class _value_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t> class map;
 template <class _key_t, class _value_t> class map_item;
 template <class _traits_t, bool _is_const> class map_iterator;
 template <class _traits_t, bool _is_const> class shared_map_iterator;
 
-template <class _key_t, class _value_t, typename _size_t, uint16_t _group_size>
+template <class _key_t, class _value_t, typename _size_t, uint16_t _group_size, class _alloc_t, class _compare_t>
 struct map_traits
 {
+using alloc_t=_alloc_t;
+using compare_t=_compare_t;
 using key_t=_key_t;
 using item_t=map_item<_key_t, _value_t>;
-using group_t=index_group<item_t, _size_t, _group_size>;
-using item_group_t=index_item_group<item_t, _size_t, _group_size>;
-using parent_group_t=index_parent_group<item_t, _size_t, _group_size>;
-using cluster_t=map<_key_t, _value_t, _size_t, _group_size>;
+using group_t=index_group<item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+using item_group_t=index_item_group<item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+using parent_group_t=index_parent_group<item_t, _size_t, _group_size, _alloc_t, _compare_t>;
+using cluster_t=map<_key_t, _value_t, _size_t, _group_size, _alloc_t, _compare_t>;
 using iterator_t=map_iterator<map_traits, false>;
 using const_iterator_t=map_iterator<map_traits, true>;
 using shared_iterator_t=shared_map_iterator<map_traits, false>;
@@ -66,6 +68,10 @@ public:
 	map_item(map_item const& item): m_key(item.m_key), m_value(item.m_value) {}
 	map_item(map_item&& item)noexcept: m_key(std::move(item.m_key)), m_value(std::move(item.m_value)) {}
 	map_item(_key_t const& key, _value_t const& value): m_key(key), m_value(value) {}
+	template <class _first_t, class _second_t> map_item(std::pair<_first_t, _second_t> const& pair): m_key(pair.first), m_value(pair.second) {}
+	template <class _key_param_t, class... _args_t> map_item(std::piecewise_construct_t, _key_param_t&& key, _args_t&&... args):
+		m_key(std::forward<_key_param_t>(key)), m_value(std::forward<_args_t>(args)...)
+		{}
 
 	// Assignment
 	inline map_item& operator=(map_item const& item)
@@ -103,17 +109,30 @@ private:
 };
 
 
+//=====
+// Key
+//=====
+
+template <class _key_t, class _value_t>
+struct index_key<map_item<_key_t, _value_t>>
+{
+using key_t=_key_t;
+static inline _key_t const& get(map_item<_key_t, _value_t> const& item)noexcept { return item.get_key(); }
+};
+
+
 //=====
 // Map
 //=====
 
-template <class _key_t, class _value_t, typename _size_t=uint32_t, uint16_t _group_size=10>
-class map: public cluster<map_traits<_key_t, _value_t, _size_t, _group_size>>
+template <class _key_t, class _value_t, typename _size_t=uint32_t, uint16_t _group_size=10, class _alloc_t=cluster_pool, class _compare_t=index_compare>
+class map: public cluster<map_traits<_key_t, _value_t, _size_t, _group_size, _alloc_t, _compare_t>>
 {
 public:
 	// Using
-	using _traits_t=map_traits<_key_t, _value_t, _size_t, _group_size>;
+	using _traits_t=map_traits<_key_t, _value_t, _size_t, _group_size, _alloc_t, _compare_t>;
 	using _base_t=cluster<_traits_t>;
+	using _builder_t=index_builder<_traits_t>;
 	using _item_t=typename _traits_t::item_t;
 	using _group_t=typename _traits_t::group_t;
 	using _item_group_t=typename _traits_t::item_group_t;
@@ -123,24 +142,25 @@ public:
 
 	// Con-/Destructors
 	map()noexcept: _base_t(nullptr) {}
-	map(map const& map): _base_t(nullptr) { this->copy_from(map); }
-	map(map&& map)noexcept: _base_t(map->m_root) { map->m_root=nullptr; }
+	map(_alloc_t const& alloc): _base_t(nullptr, alloc) {}
+	map(map const& map): _base_t(nullptr, map.m_alloc) { this->copy_from(map); }
+	map(map&& map)noexcept: _base_t(std::move(map)) {}
+	template <class _it_t> map(_it_t first, _it_t last): _base_t(nullptr) { assign_sorted(first, last); }
 
 	// Access
 	template <class _key_param_t> inline _value_t& operator[](_key_param_t const& key) { return get(key); }
 	template <class _key_param_t> inline _value_t const& operator[](_key_param_t const& key)const { return get(key); }
-	inline const_iterator cfind(_key_t const& key, find_func func=find_func::equal)const
+	template <class _key_param_t> inline const_iterator cfind(_key_param_t const& key, find_func func=find_func::equal)const
 		{
 		const_iterator it(this);
 		it.find(key, func);
 		return it;
 		}
-	inline bool contains(_key_t const& key)const
+	template <class _key_param_t> inline bool contains(_key_param_t const& key)const
 		{
-		_item_t item(key, _value_t());
-		return get_internal(item)!=nullptr;
+		return get_internal(key)!=nullptr;
 		}
-	inline iterator find(_key_t const& key, find_func func=find_func::equal)
+	template <class _key_param_t> inline iterator find(_key_param_t const& key, find_func func=find_func::equal)
 		{
 		iterator it(this);
 		it.find(key, func);
@@ -148,38 +168,33 @@ public:
 		}
 	template <class _key_param_t> _value_t& get(_key_param_t const& key)
 		{
-		_item_t item(key, _value_t());
 		bool created=false;
-		auto got=get_internal(std::forward<_item_t>(item), &created);
+		auto got=emplace_internal(key, &created);
 		return got->get_value();
 		}
 	template <class _key_param_t, class _value_param_t> _value_t& get(_key_param_t const& key, _value_param_t const& value)
 		{
-		_item_t item(key, value);
 		bool created=false;
-		auto got=get_internal(std::forward<_item_t>(item), &created);
+		auto got=emplace_internal(key, &created, value);
 		return got->get_value();
 		}
 	template <class _key_param_t> _value_t const& get(_key_param_t const& key)const
 		{
-		_item_t item(key, _value_t());
-		auto got=get_internal(item);
+		auto got=get_internal(key);
 		if(!got)
 			throw std::out_of_range(nullptr);
 		return got->get_value();
 		}
-	template <class _key_param_t> inline bool index_of(_key_param_t const& key, _size_t* pos_ptr)
+	template <class _key_param_t> inline bool index_of(_key_param_t const& key, _size_t* pos_ptr)const
 		{
-		_item_t item(key, _value_t());
 		auto root=this->m_root;
 		if(!root)
 			return false;
-		return root->index_of(item, pos_ptr);
+		return root->index_of(key, pos_ptr);
 		}
 	template <class _key_param_t> bool try_get(_key_param_t const& key, _value_t* value_ptr)const
 		{
-		_item_t item(key, _value_t());
-		auto got=get_internal(item);
+		auto got=get_internal(key);
 		if(!got)
 			return false;
 		if(value_ptr)
@@ -193,39 +208,86 @@ public:
 		this->copy_from(map);
 		return *this;
 		}
-	template <class _key_param_t, class _value_param_t> bool add(_key_param_t const& key, _value_param_t const& value)
+	template <class _key_param_t, class _value_param_t> inline bool add(_key_param_t const& key, _value_param_t const& value) { return try_emplace(key, value); }
+	inline _size_t add_many(_item_t const* items, _size_t count) { return add_many_internal(items, count, false); }
+	template <class _it_t> void assign_sorted(_it_t first, _it_t last)
 		{
-		_item_t item(key, value);
-		bool created=false;
-		get_internal(std::forward<_item_t>(item), &created);
-		return created;
+		_builder_t builder(this->m_alloc);
+		for(; first!=last; ++first)
+			builder.emplace(*first);
+		this->clear();
+		this->m_root=builder.finish();
+		}
+	template <class _key_param_t> _size_t erase_range(_key_param_t const& first, _key_param_t const& last)
+		{
+		auto root=this->m_root;
+		if(!root)
+			return 0;
+		_size_t start=root->get_lower_bound(first);
+		_size_t end=root->get_lower_bound(last);
+		if(end<=start)
+			return 0;
+		this->remove_range(start, end-start);
+		return end-start;
+		}
+	void join(map&& map)
+		{
+		auto root=this->m_root;
+		auto tail_root=map.m_root;
+		if(root&&tail_root)
+			{
+			if(index_order<_compare_t>::compare(root->get_last(), tail_root->get_first())>=0)
+				throw std::invalid_argument("keys not ascending");
+			}
+		this->concat_from(map);
 		}
-	bool remove(_key_t const& key, _value_t* value_ptr=nullptr)
+	template <class _key_param_t> bool remove(_key_param_t const& key, _value_t* value_ptr=nullptr)
 		{
+		unshare_key(key);
 		auto root=this->m_root;
 		if(!root)
 			return false;
-		_item_t item(key, _value_t());
+		if(!value_ptr)
+			{
+			if(!root->remove(this->m_alloc, key, nullptr))
+				return false;
+			this->drop_root();
+			return true;
+			}
 		_item_t removed;
-		if(!root->remove(item, &removed))
+		if(!root->remove(this->m_alloc, key, &removed))
 			return false;
-		if(value_ptr)
-			*value_ptr=removed.get_value();
+		this->drop_root();
+		*value_ptr=std::move(removed.get_value());
 		return true;
 		}
 	template <class _key_param_t, class _value_param_t> bool set(_key_param_t const& key, _value_param_t const& value)
 		{
-		_item_t item(key, value);
 		bool created=false;
-		auto got=get_internal(std::forward<_item_t>(item), &created);
+		auto got=emplace_internal(key, &created, value);
 		if(!created)
 			{
-			if(got->get_value()==item.get_value())
+			if(got->get_value()==value)
 				return false;
-			got->set_value(std::forward<_value_t>(item.get_value()));
+			got->set_value(value);
 			}
 		return true;
 		}
+	inline _size_t set_many(_item_t const* items, _size_t count) { return add_many_internal(items, count, true); }
+	template <class _key_param_t> map split(_key_param_t const& key)
+		{
+		_size_t position=0;
+		auto root=this->m_root;
+		if(root)
+			position=root->get_lower_bound(key);
+		return this->split_at(position);
+		}
+	template <class _key_param_t, class... _args_t> bool try_emplace(_key_param_t const& key, _args_t&&... args)
+		{
+		bool created=false;
+		emplace_internal(key, &created, std::forward<_args_t>(args)...);
+		return created;
+		}
 
 protected:
 	// Con-/Destructors
@@ -233,21 +295,57 @@ protected:
 
 private:
 	// Common
-	_item_t const* get_internal(_item_t const& item)const noexcept
+	_size_t add_many_internal(_item_t const* items, _size_t count, bool replace)
+		{
+		index_batch<_traits_t> batch(items, count, replace);
+		auto sorted=batch.get_items();
+		count=batch.get_count();
+		this->unshare_root();
+		_size_t created=0;
+		_size_t pos=0;
+		while(pos<count)
+			{
+			auto root=this->create_root();
+			_size_t added=root->add_many(this->m_alloc, &sorted[pos], count-pos, replace, &created);
+			if(added)
+				{
+				pos+=added;
+				continue;
+				}
+			auto const& item=*sorted[pos];
+			bool item_created=false;
+			emplace_internal(item.get_key(), &item_created, item.get_value());
+			if(item_created)
+				created++;
+			pos++;
+			}
+		return created;
+		}
+	template <class _key_param_t> _item_t const* get_internal(_key_param_t const& key)const noexcept
 		{
 		auto root=this->m_root;
 		if(!root)
 			return nullptr;
-		return root->get(item);
+		return root->get(key);
 		}
-	_item_t* get_internal(_item_t&& item, bool* created)
+	template <class _key_param_t, class... _args_t> _item_t* emplace_internal(_key_param_t const& key, bool* created, _args_t&&... args)
 		{
+		this->unshare_root();
 		auto root=this->create_root();
-		auto got=root->get(std::forward<_item_t>(item), created, false);
+		auto got=root->emplace(this->m_alloc, key, created, false, std::piecewise_construct, key, std::forward<_args_t>(args)...);
 		if(got)
 			return got;
 		root=this->lift_root();
-		return root->get(std::forward<_item_t>(item), created, true);
+		return root->emplace(this->m_alloc, key, created, true, std::piecewise_construct, key, std::forward<_args_t>(args)...);
+		}
+	template <class _key_param_t> void unshare_key(_key_param_t const& key)
+		{
+		// Groups are only combined on the path when removing.
+		auto root=this->m_root;
+		if(!this->m_shared||!root)
+			return;
+		_size_t position=root->get_lower_bound(key);
+		this->unshare(position, position);
 		}
 };
 
@@ -277,8 +375,7 @@ public:
 	// Navigation
 	template <class _key_param_t> inline bool find(_key_param_t const& key, find_func func=find_func::equal)
 		{
-		_item_t item(key, _value_t());
-		return _base_t::find(item, func);
+		return _base_t::find(key, func);
 		}
 };
 
@@ -302,8 +399,7 @@ public:
 	// Navigation
 	template <class _key_param_t> inline bool find(_key_param_t const& key, find_func func=find_func::equal)
 		{
-		_item_t item(key, _value_t());
-		return _base_t::find(item, func);
+		return _base_t::find(key, func);
 		}
 };
 
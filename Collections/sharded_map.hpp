@@ -0,0 +1,418 @@
+//=================
+// sharded_map.hpp
+//=================
+
+// Thread-safe implementation of a sorted map split into key-ranges.
+// Each range is stored in a separate map with its own lock.
+
+// Copyright 2026, Sven Bieg (svenbieg@outlook.de)
+// https://github.com/svenbieg/Clusters/wiki/Map
+
+#pragma once
+
+
+//=======
+// Using
+//=======
+
+#include <memory>
+#include <optional>
+#include "Collections/map.hpp"
+#include "Collections/shared_cluster.hpp"
+
+
+//===========
+// Namespace
+//===========
+
+namespace Collections {
+
+
+//==========
+// Iterator
+//==========
+
+// The iterator holds the shared lock of the sharded map and of the current shard,
+// shards are not split or merged while being iterated.
+
+template <class _sharded_t>
+class sharded_map_iterator
+{
+public:
+	// Using
+	using _traits_t=typename _sharded_t::_traits_t;
+	using _const_iterator_t=typename _traits_t::const_iterator_t;
+	using _item_t=typename _traits_t::item_t;
+	using _key_t=typename _traits_t::key_t;
+	using _size_t=typename _traits_t::size_t;
+	using _value_t=typename _traits_t::value_t;
+
+	// Con-/Destructors
+	sharded_map_iterator(_sharded_t* map): m_map(map), m_lock(map->m_mutex, std::defer_lock), m_offset(0), m_shard(0) {}
+	sharded_map_iterator(sharded_map_iterator const&)=delete;
+	sharded_map_iterator(sharded_map_iterator&&)=default;
+
+	// Access
+	inline _item_t const& operator*()const { return get_current(); }
+	inline _item_t const* operator->()const { return &get_current(); }
+	_item_t const& get_current()const
+		{
+		if(!m_it)
+			throw std::out_of_range(nullptr);
+		return m_it->get_current();
+		}
+	inline _key_t const& get_key()const { return get_current().get_key(); }
+	inline _size_t get_position()const noexcept { return m_it? m_offset+m_it->get_position(): -2; }
+	inline _value_t const& get_value()const { return get_current().get_value(); }
+	inline bool has_current()const noexcept { return m_it&&m_it->has_current(); }
+
+	// Navigation
+	inline sharded_map_iterator& operator++()
+		{
+		move_next();
+		return *this;
+		}
+	bool begin()
+		{
+		lock();
+		return open_shard(0, 0);
+		}
+	template <class _key_param_t> bool find(_key_param_t const& key, find_func func=find_func::equal)
+		{
+		// Items above or below the key are looked-up in the neighbouring shards.
+		lock();
+		uint16_t shard=m_map->get_shard(key);
+		_size_t offset=0;
+		for(uint16_t u=0; u<shard; u++)
+			offset+=m_map->get_shard_size(u);
+		auto shard_ptr=m_map->m_shards[shard].get();
+		lock_shard(shard_ptr);
+		m_shard=shard;
+		m_offset=offset;
+		m_it.emplace(&shard_ptr->map);
+		if(m_it->find(key, func))
+			return true;
+		switch(func)
+			{
+			case find_func::above:
+			case find_func::above_or_equal:
+			case find_func::any:
+				{
+				offset+=shard_ptr->map.get_count();
+				return open_shard(shard+1, offset);
+				}
+			case find_func::below:
+			case find_func::below_or_equal:
+				{
+				while(shard>0)
+					{
+					shard--;
+					shard_ptr=m_map->m_shards[shard].get();
+					lock_shard(shard_ptr);
+					_size_t count=shard_ptr->map.get_count();
+					offset-=count;
+					if(!count)
+						continue;
+					m_shard=shard;
+					m_offset=offset;
+					m_it.emplace(&shard_ptr->map, count-1);
+					return true;
+					}
+				break;
+				}
+			default:
+				break;
+			}
+		unlock();
+		return false;
+		}
+	bool move_next()
+		{
+		if(!m_it)
+			return false;
+		if(m_it->move_next())
+			return true;
+		_size_t offset=m_offset+m_map->m_shards[m_shard]->map.get_count();
+		return open_shard(m_shard+1, offset);
+		}
+
+private:
+	// Common
+	inline void lock()
+		{
+		if(!m_lock.owns_lock())
+			m_lock.lock();
+		}
+	template <class _shard_t> void lock_shard(_shard_t* shard)
+		{
+		m_it.reset();
+		if(m_shard_lock.owns_lock())
+			m_shard_lock.unlock();
+		m_shard_lock=std::shared_lock<shared_cluster_mutex>(shard->mutex);
+		}
+	bool open_shard(uint16_t shard, _size_t offset)
+		{
+		// Empty shards are skipped, the locks are released at the end.
+		uint16_t shard_count=(uint16_t)m_map->m_shards.size();
+		for(; shard<shard_count; shard++)
+			{
+			auto shard_ptr=m_map->m_shards[shard].get();
+			lock_shard(shard_ptr);
+			_size_t count=shard_ptr->map.get_count();
+			if(!count)
+				continue;
+			m_shard=shard;
+			m_offset=offset;
+			m_it.emplace(&shard_ptr->map, 0);
+			return true;
+			}
+		unlock();
+		return false;
+		}
+	void unlock()noexcept
+		{
+		m_it.reset();
+		if(m_shard_lock.owns_lock())
+			m_shard_lock.unlock();
+		if(m_lock.owns_lock())
+			m_lock.unlock();
+		}
+	_sharded_t* m_map;
+	std::shared_lock<shared_cluster_mutex> m_lock;
+	_size_t m_offset;
+	uint16_t m_shard;
+	std::shared_lock<shared_cluster_mutex> m_shard_lock;
+	std::optional<_const_iterator_t> m_it;
+};
+
+
+//=============
+// Sharded Map
+//=============
+
+template <typename _key_t, typename _value_t, typename _size_t=uint32_t, uint16_t _group_size=10, class _alloc_t=cluster_pool, class _compare_t=index_compare>
+class sharded_map
+{
+public:
+	// Friends
+	friend class sharded_map_iterator<sharded_map>;
+
+	// Using
+	using _traits_t=map_traits<_key_t, _value_t, _size_t, _group_size, _alloc_t, _compare_t>;
+	using _map_t=typename _traits_t::cluster_t;
+	using _item_t=typename _map_t::_item_t;
+	using _order_t=index_order<_compare_t>;
+	using const_iterator=sharded_map_iterator<sharded_map>;
+
+	// Con-/Destructors
+	sharded_map()
+		{
+		m_shards.emplace_back(new shard_t());
+		}
+	sharded_map(_key_t const* splits, uint16_t count)
+		{
+		for(uint16_t u=1; u<count; u++)
+			{
+			if(_order_t::compare(splits[u-1], splits[u])>=0)
+				throw std::invalid_argument("keys not ascending");
+			}
+		m_splits.assign(splits, splits+count);
+		for(uint16_t u=0; u<=count; u++)
+			m_shards.emplace_back(new shard_t());
+		}
+	sharded_map(sharded_map const&)=delete;
+
+	// Access
+	inline const_iterator cbegin()
+		{
+		const_iterator it(this);
+		it.begin();
+		return it;
+		}
+	template <class _key_param_t> inline const_iterator cfind(_key_param_t const& key, find_func func=find_func::equal)
+		{
+		const_iterator it(this);
+		it.find(key, func);
+		return it;
+		}
+	template <class _key_param_t> bool contains(_key_param_t const& key)
+		{
+		return m_mutex.read([&]()
+			{
+			auto shard=m_shards[get_shard(key)].get();
+			return shard->mutex.read([&]() { return shard->map.contains(key); });
+			});
+		}
+	template <class _key_param_t> _value_t get(_key_param_t const& key)
+		{
+		// Missing values are created with the unique lock of the shard.
+		_value_t value;
+		if(try_get(key, &value))
+			return value;
+		return write_shard(key, [&](_map_t& map) { return map.get(key); });
+		}
+	_size_t get_count()
+		{
+		return m_mutex.read([&]()
+			{
+			_size_t count=0;
+			uint16_t shard_count=(uint16_t)m_shards.size();
+			for(uint16_t u=0; u<shard_count; u++)
+				count+=get_shard_size(u);
+			return count;
+			});
+		}
+	inline uint16_t get_shard_count()
+		{
+		return m_mutex.read([&]() { return (uint16_t)m_shards.size(); });
+		}
+	template <class _key_param_t> bool index_of(_key_param_t const& key, _size_t* pos_ptr)
+		{
+		// The rank is the sum of the shards below, they are counted one after another.
+		return m_mutex.read([&]()
+			{
+			uint16_t shard=get_shard(key);
+			_size_t offset=0;
+			for(uint16_t u=0; u<shard; u++)
+				offset+=get_shard_size(u);
+			auto shard_ptr=m_shards[shard].get();
+			_size_t pos=0;
+			if(!shard_ptr->mutex.read([&]() { return shard_ptr->map.index_of(key, &pos); }))
+				return false;
+			*pos_ptr=offset+pos;
+			return true;
+			});
+		}
+	template <class _key_param_t> bool try_get(_key_param_t const& key, _value_t* value)
+		{
+		return m_mutex.read([&]()
+			{
+			auto shard=m_shards[get_shard(key)].get();
+			return shard->mutex.read([&]() { return shard->map.try_get(key, value); });
+			});
+		}
+
+	// Modification
+	template <class _key_param_t, class _value_param_t> inline bool add(_key_param_t const& key, _value_param_t const& value)
+		{
+		return write_shard(key, [&](_map_t& map) { return map.add(key, value); });
+		}
+	template <class _key_param_t> bool add_split(_key_param_t const& key)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		uint16_t shard=get_shard(key);
+		if(shard>0&&_order_t::compare(m_splits[shard-1], key)==0)
+			return false;
+		split_shard(shard, key);
+		return true;
+		}
+	void clear()
+		{
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		for(auto& shard: m_shards)
+			shard->map.clear();
+		}
+	template <class _key_param_t> inline bool remove(_key_param_t const& key)
+		{
+		return write_shard(key, [&](_map_t& map) { return map.remove(key); });
+		}
+	bool remove_split(uint16_t position)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		if(position>=m_splits.size())
+			return false;
+		m_shards[position]->map.join(std::move(m_shards[position+1]->map));
+		m_shards.erase(m_shards.begin()+position+1);
+		m_splits.erase(m_splits.begin()+position);
+		return true;
+		}
+	template <class _key_param_t, class _value_param_t> inline bool set(_key_param_t const& key, _value_param_t const& value)
+		{
+		return write_shard(key, [&](_map_t& map) { return map.set(key, value); });
+		}
+	bool split_shard(uint16_t shard)
+		{
+		// The shard is split at the key in the middle.
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		if(shard>=m_shards.size())
+			return false;
+		auto& map=m_shards[shard]->map;
+		_size_t count=map.get_count();
+		if(count<2)
+			return false;
+		typename _map_t::const_iterator it(&map, count/2);
+		_key_t key=it.get_key();
+		split_shard(shard, key);
+		return true;
+		}
+	template <class _key_param_t, class... _args_t> inline bool try_emplace(_key_param_t const& key, _args_t const&... args)
+		{
+		return write_shard(key, [&](_map_t& map) { return map.try_emplace(key, args...); });
+		}
+
+private:
+	// Shard
+	struct shard_t
+		{
+		shard_t() {}
+		shard_t(_map_t&& map): map(std::move(map)) {}
+		_map_t map;
+		shared_cluster_mutex mutex;
+		};
+
+	// Common
+	template <class _key_param_t> uint16_t get_shard(_key_param_t const& key)const noexcept
+		{
+		// Keys of a shard are between the split below and the split above.
+		uint16_t start=0;
+		uint16_t end=(uint16_t)m_splits.size();
+		while(start<end)
+			{
+			uint16_t pos=start+(end-start)/2;
+			if(_order_t::compare(m_splits[pos], key)>0)
+				{
+				end=pos;
+				}
+			else
+				{
+				start=pos+1;
+				}
+			}
+		return start;
+		}
+	_size_t get_shard_size(uint16_t shard)
+		{
+		auto shard_ptr=m_shards[shard].get();
+		return shard_ptr->mutex.read([&]() { return shard_ptr->map.get_count(); });
+		}
+	void split_shard(uint16_t shard, _key_t const& key)
+		{
+		// Called with the unique lock, no shard is in use.
+		m_shards.reserve(m_shards.size()+1);
+		m_splits.insert(m_splits.begin()+shard, key);
+		try
+			{
+			std::unique_ptr<shard_t> tail(new shard_t(m_shards[shard]->map.split(key)));
+			m_shards.insert(m_shards.begin()+shard+1, std::move(tail));
+			}
+		catch(...)
+			{
+			m_splits.erase(m_splits.begin()+shard);
+			throw;
+			}
+		}
+	template <class _key_param_t, class _func_t> auto write_shard(_key_param_t const& key, _func_t&& func)
+		{
+		return m_mutex.read([&]()
+			{
+			auto shard=m_shards[get_shard(key)].get();
+			std::unique_lock<shared_cluster_mutex> lock(shard->mutex);
+			return func(shard->map);
+			});
+		}
+	shared_cluster_mutex m_mutex;
+	std::vector<std::unique_ptr<shard_t>> m_shards;
+	std::vector<_key_t> m_splits;
+};
+
+}
\ No newline at end of file
@@ -15,8 +15,10 @@
 // Using
 //=======
 
+#include <atomic>
 #include <mutex>
 #include <shared_mutex>
+#include <thread>
 #include "Collections/cluster.hpp"
 
 
@@ -31,7 +33,127 @@ namespace Collections {
 // Forward-Declarations
 //======================
 
+template <typename _traits_t> class shared_cluster_cursor;
 template <typename _traits_t, bool _is_const> class shared_cluster_iterator_base;
+template <typename _traits_t> class shared_index_cursor;
+
+
+//=======
+// Mutex
+//=======
+
+// Point-reads don't take the lock, the readers are announced in the slot of their thread.
+// Writers wait for the readers in the slots, groups are never modified or freed while being read.
+
+class shared_cluster_mutex
+{
+public:
+	// Con-/Destructors
+	shared_cluster_mutex()noexcept: m_mutex(), m_writing(false) {}
+	shared_cluster_mutex(shared_cluster_mutex const&)=delete;
+
+	// Locking
+	void lock()
+		{
+		m_mutex.lock();
+		wait_for_readers();
+		}
+	inline void lock_shared() { m_mutex.lock_shared(); }
+	bool try_lock()
+		{
+		if(!m_mutex.try_lock())
+			return false;
+		wait_for_readers();
+		return true;
+		}
+	inline bool try_lock_shared() { return m_mutex.try_lock_shared(); }
+	void unlock()noexcept
+		{
+		m_writing.store(false, std::memory_order_release);
+		m_mutex.unlock();
+		}
+	inline void unlock_shared()noexcept { m_mutex.unlock_shared(); }
+
+	// Common
+	template <class _func_t> auto read(_func_t&& func)
+		{
+		// The shared lock is taken while writing or if all slots are used.
+		auto slot=enter_reader();
+		if(slot)
+			{
+			try
+				{
+				auto result=func();
+				slot->reader.store(nullptr, std::memory_order_release);
+				return result;
+				}
+			catch(...)
+				{
+				slot->reader.store(nullptr, std::memory_order_release);
+				throw;
+				}
+			}
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		return func();
+		}
+
+private:
+	// Settings
+	static const unsigned int _slot_count=64;
+
+	// Slot
+	struct alignas(64) slot_t
+		{
+		std::atomic<void const*> reader;
+		};
+
+	// Access
+	static inline unsigned int get_slot()noexcept
+		{
+		static std::atomic<unsigned int> next(0);
+		thread_local unsigned int slot=next++%_slot_count;
+		return slot;
+		}
+	static inline slot_t* get_slots()noexcept
+		{
+		static slot_t slots[_slot_count]={};
+		return slots;
+		}
+
+	// Common
+	slot_t* enter_reader()noexcept
+		{
+		// The slot of the thread is tried first, the others are only written if free.
+		auto slots=get_slots();
+		unsigned int first=get_slot();
+		for(unsigned int u=0; u<_slot_count; u++)
+			{
+			auto slot=&slots[(first+u)%_slot_count];
+			if(slot->reader.load(std::memory_order_relaxed)!=nullptr)
+				continue;
+			void const* free=nullptr;
+			if(!slot->reader.compare_exchange_strong(free, this))
+				continue;
+			if(!m_writing.load())
+				return slot;
+			slot->reader.store(nullptr, std::memory_order_release);
+			return nullptr;
+			}
+		return nullptr;
+		}
+	void wait_for_readers()noexcept
+		{
+		m_writing.store(true);
+		auto slots=get_slots();
+		for(unsigned int u=0; u<_slot_count; u++)
+			{
+			while(slots[u].reader.load()==this)
+				std::this_thread::yield();
+			}
+		}
+	std::shared_mutex m_mutex;
+	std::atomic<bool> m_writing;
+};
 
 
 //================
@@ -43,12 +165,17 @@ class shared_cluster: protected _traits_t::cluster_t
 {
 public:
 	// Friends
+	friend class shared_cluster_cursor<_traits_t>;
 	friend class shared_cluster_iterator_base<_traits_t, true>;
 	friend class shared_cluster_iterator_base<_traits_t, false>;
+	friend class shared_index_cursor<_traits_t>;
 
 	// Using
+	using _alloc_t=typename _traits_t::alloc_t;
+	using _allocator_t=cluster_allocator<_traits_t>;
 	using _base_t=typename _traits_t::cluster_t;
 	using _cluster_t=typename _traits_t::cluster_t;
+	using _group_t=typename _traits_t::group_t;
 	using _item_t=typename _traits_t::item_t;
 	using _size_t=typename _traits_t::size_t;
 
@@ -58,47 +185,108 @@ public:
 	// Access
 	inline _item_t get_at(_size_t position)
 		{
-		std::shared_lock<std::shared_mutex> lock(m_mutex);
-		return _cluster_t::get_at(position);
+		return m_mutex.read([&]() { return ((_cluster_t const*)this)->get_at(position); });
+		}
+	template <class _func_t> inline bool for_each_chunk(_func_t&& func)
+		{
+		std::shared_lock<shared_cluster_mutex> lock(m_mutex);
+		return ((_cluster_t const*)this)->for_each_chunk(std::forward<_func_t>(func));
+		}
+	template <class _func_t> inline bool for_each_chunk(_size_t position, _size_t count, _func_t&& func)
+		{
+		std::shared_lock<shared_cluster_mutex> lock(m_mutex);
+		return ((_cluster_t const*)this)->for_each_chunk(position, count, std::forward<_func_t>(func));
 		}
 	inline _size_t get_count()
 		{
-		std::shared_lock<std::shared_mutex> lock(m_mutex);
-		return _cluster_t::get_count();
+		return m_mutex.read([&]() { return _cluster_t::get_count(); });
+		}
+	template <class _func_t> inline void parallel_for_each(_func_t&& func, unsigned int thread_count=0)
+		{
+		std::shared_lock<shared_cluster_mutex> lock(m_mutex);
+		((_cluster_t const*)this)->parallel_for_each(std::forward<_func_t>(func), thread_count);
+		}
+	template <class _value_t, class _map_t, class _combine_t> inline _value_t parallel_reduce(_value_t const& identity, _map_t&& map, _combine_t&& combine, unsigned int thread_count=0)
+		{
+		std::shared_lock<shared_cluster_mutex> lock(m_mutex);
+		return _cluster_t::parallel_reduce(identity, std::forward<_map_t>(map), std::forward<_combine_t>(combine), thread_count);
+		}
+	_cluster_t snapshot()
+		{
+		// The snapshot shares the groups and can be read without the lock,
+		// groups are copied by the side modifying them and freed with the last reference.
+		_cluster_t snapshot(this->m_alloc);
+		std::shared_lock<shared_cluster_mutex> lock(m_mutex);
+		if constexpr(cluster_alloc_parallel<_alloc_t>::value)
+			{
+			this->share_to(snapshot);
+			}
+		else
+			{
+			snapshot.copy_from(*this);
+			}
+		return snapshot;
 		}
 
 	// Modification
 	inline bool clear()
 		{
-		std::unique_lock<std::shared_mutex> lock(m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
 		return _cluster_t::clear();
 		}
 	inline void copy_from(_cluster_t&& cluster)
 		{
-		std::unique_lock<std::shared_mutex> lock(m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
 		_cluster_t::copy_from(std::forward<_cluster_t>(cluster));
 		}
 	inline void copy_from(_cluster_t const& cluster)
 		{
-		std::unique_lock<std::shared_mutex> lock(m_mutex);
-		_cluster_t::copy_from(cluster);
+		if constexpr(cluster_alloc_parallel<_alloc_t>::value)
+			{
+			bool shared=false;
+			auto root=copy_root(cluster, &shared);
+			replace_root(root, shared);
+			}
+		else
+			{
+			std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+			_cluster_t::copy_from(cluster);
+			}
 		}
 	inline void copy_from(shared_cluster& cluster)
 		{
-		std::unique_lock<std::shared_mutex> lock(m_mutex);
-		std::shared_lock<std::shared_mutex> shared_lock(cluster.m_mutex);
-		_cluster_t::copy_from(cluster);
+		if(this==&cluster)
+			return;
+		if constexpr(cluster_alloc_parallel<_alloc_t>::value)
+			{
+			bool shared=false;
+			std::shared_lock<shared_cluster_mutex> shared_lock(cluster.m_mutex);
+			auto root=copy_root(cluster, &shared);
+			shared_lock.unlock();
+			replace_root(root, shared);
+			}
+		else
+			{
+			std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+			std::shared_lock<shared_cluster_mutex> shared_lock(cluster.m_mutex);
+			_cluster_t::copy_from(cluster);
+			}
 		}
 	inline void copy_from(shared_cluster&& cluster)
 		{
-		std::unique_lock<std::shared_mutex> lock(m_mutex);
-		std::unique_lock<std::shared_mutex> src_lock(cluster.m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		std::unique_lock<shared_cluster_mutex> src_lock(cluster.m_mutex);
 		_cluster_t::copy_from(std::forward<_cluster_t>(cluster));
 		}
-	inline bool remove_at(_size_t position, _item_t* item_ptr=nullptr)
+	inline void remove_at(_size_t position, _item_t* item_ptr=nullptr)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		_cluster_t::remove_at(position, item_ptr);
+		}
+	inline void remove_range(_size_t position, _size_t count)
 		{
-		std::unique_lock<std::shared_mutex> lock(m_mutex);
-		return _cluster_t::remove_at(position, item_ptr);
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		_cluster_t::remove_range(position, count);
 		}
 
 protected:
@@ -106,13 +294,34 @@ protected:
 	shared_cluster(): _base_t(nullptr) {}
 
 	// Modification
-	inline bool remove_internal(_size_t position)
+	inline void remove_internal(_size_t position)
 		{
-		return _cluster_t::remove_at(position);
+		_cluster_t::remove_at(position);
 		}
 
 	// Common
-	std::shared_mutex m_mutex;
+	// Groups are copied and freed with separate allocators, the lock is only held for the exchange.
+	_group_t* copy_root(_cluster_t const& cluster, bool* shared_ptr)
+		{
+		_alloc_t alloc(this->m_alloc);
+		return _cluster_t::copy_root(alloc, cluster, shared_ptr);
+		}
+	void replace_root(_group_t* root, bool shared)noexcept
+		{
+		std::unique_lock<shared_cluster_mutex> lock(m_mutex);
+		auto old_root=this->m_root;
+		this->m_root=root;
+		this->m_shared=shared;
+		if(shared)
+			this->m_persistent=true;
+		lock.unlock();
+		if(old_root)
+			{
+			_alloc_t alloc(this->m_alloc);
+			_allocator_t::free_group(alloc, old_root);
+			}
+		}
+	shared_cluster_mutex m_mutex;
 };
 
 
@@ -216,7 +425,14 @@ protected:
 	void lock()
 		{
 		auto cluster=(_shared_cluster_t*)this->m_cluster;
-		_is_const? cluster->m_mutex.lock_shared(): cluster->m_mutex.lock();
+		if constexpr(_is_const)
+			{
+			cluster->m_mutex.lock_shared();
+			}
+		else
+			{
+			cluster->m_mutex.lock();
+			}
 		}
 	bool rbegin()
 		{
@@ -284,6 +500,57 @@ public:
 };
 
 
+//========
+// Cursor
+//========
+
+// Items are read in chunks with the shared lock, the lock is released between the chunks.
+// The cursor resumes at its position, items inserted or removed below are moving it.
+
+template <typename _traits_t>
+class shared_cluster_cursor
+{
+public:
+	// Using
+	using _cluster_t=typename _traits_t::cluster_t;
+	using _const_iterator_t=typename _traits_t::const_iterator_t;
+	using _item_t=typename _traits_t::item_t;
+	using _shared_cluster_t=shared_cluster<_traits_t>;
+	using _size_t=typename _traits_t::size_t;
+
+	// Con-/Destructors
+	shared_cluster_cursor(_shared_cluster_t* cluster, _size_t position=0)noexcept: m_cluster(cluster), m_position(position) {}
+
+	// Access
+	inline _size_t get_position()const noexcept { return m_position; }
+
+	// Navigation
+	template <class _func_t> _size_t for_each(_size_t count, _func_t&& func)
+		{
+		std::shared_lock<shared_cluster_mutex> lock(m_cluster->m_mutex);
+		_const_iterator_t it((_cluster_t const*)m_cluster, m_position);
+		_size_t visited=0;
+		for(; visited<count&&it.has_current(); it.move_next())
+			{
+			func(it.get_current());
+			visited++;
+			}
+		m_position+=visited;
+		return visited;
+		}
+	inline _size_t get_many(_item_t* items, _size_t count)
+		{
+		return for_each(count, [items](_item_t const& item) mutable { *items++=item; });
+		}
+	inline void reset(_size_t position=0)noexcept { m_position=position; }
+
+private:
+	// Common
+	_shared_cluster_t* m_cluster;
+	_size_t m_position;
+};
+
+
 //=========================
 // Iterable Shared Cluster
 //=========================
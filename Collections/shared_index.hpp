@@ -15,6 +15,7 @@
 // Using
 //=======
 
+#include <optional>
 #include "Collections/index.hpp"
 #include "Collections/shared_cluster.hpp"
 
@@ -37,17 +38,17 @@ public:
 	// Using
 	using _base_t=shared_cluster_iterator<_traits_t, _is_const>;
 	using _item_t=typename _traits_t::item_t;
-	using _iterator_t=typename _traits_t::iterator_t;
+	using _iterator_t=typename std::conditional<_is_const, typename _traits_t::const_iterator_t, typename _traits_t::iterator_t>::type;
 
 	// Con-/Destructors
 	using _base_t::_base_t;
 
 	// Navigation
-	bool find(_item_t const& item, find_func func=find_func::equal)
+	template <class _key_param_t> bool find(_key_param_t const& key, find_func func=find_func::equal)
 		{
 		if(this->is_outside())
 			this->lock();
-		if(!_iterator_t::find(item, func))
+		if(!_iterator_t::find(key, func))
 			{
 			this->unlock();
 			return false;
@@ -57,17 +58,83 @@ public:
 };
 
 
+//========
+// Cursor
+//========
+
+// Items are read in chunks with the shared lock, the lock is released between the chunks.
+// The cursor resumes above the last key, items inserted or removed meanwhile are no problem.
+
+template <typename _traits_t>
+class shared_index_cursor
+{
+public:
+	// Using
+	using _cluster_t=typename _traits_t::cluster_t;
+	using _const_iterator_t=typename _traits_t::const_iterator_t;
+	using _item_t=typename _traits_t::item_t;
+	using _item_key_t=index_key<_item_t>;
+	using _key_t=typename _item_key_t::key_t;
+	using _shared_cluster_t=shared_cluster<_traits_t>;
+	using _size_t=typename _traits_t::size_t;
+
+	// Con-/Destructors
+	shared_index_cursor(_shared_cluster_t* cluster)noexcept: m_cluster(cluster) {}
+
+	// Access
+	inline _key_t const* get_last()const noexcept { return m_last? &*m_last: nullptr; }
+
+	// Navigation
+	template <class _func_t> _size_t for_each(_size_t count, _func_t&& func)
+		{
+		std::shared_lock<shared_cluster_mutex> lock(m_cluster->m_mutex);
+		_const_iterator_t it((_cluster_t const*)m_cluster);
+		if(m_last)
+			{
+			it.find(*m_last, find_func::above);
+			}
+		else
+			{
+			it.begin();
+			}
+		_item_t const* last=nullptr;
+		_size_t visited=0;
+		for(; visited<count&&it.has_current(); it.move_next())
+			{
+			last=&it.get_current();
+			func(*last);
+			visited++;
+			}
+		if(last)
+			m_last=_item_key_t::get(*last);
+		return visited;
+		}
+	inline _size_t get_many(_item_t* items, _size_t count)
+		{
+		return for_each(count, [items](_item_t const& item) mutable { *items++=item; });
+		}
+	inline void reset()noexcept { m_last.reset(); }
+	template <class _key_param_t> inline void reset(_key_param_t const& key) { m_last=key; }
+
+private:
+	// Common
+	_shared_cluster_t* m_cluster;
+	std::optional<_key_t> m_last;
+};
+
+
 //==============
 // Shared Index
 //==============
 
-template <typename _item_t, typename _size_t=uint32_t, uint16_t _group_size=10>
-class shared_index: public iterable_shared_cluster<index_traits<_item_t, _size_t, _group_size>>
+template <typename _item_t, typename _size_t=uint32_t, uint16_t _group_size=10, class _alloc_t=cluster_pool, class _compare_t=index_compare>
+class shared_index: public iterable_shared_cluster<index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>>
 {
 public:
 	// Using
-	using _traits_t=index_traits<_item_t, _item_t, _size_t, _group_size>;
+	using _traits_t=index_traits<_item_t, _size_t, _group_size, _alloc_t, _compare_t>;
 	using _cluster_t=typename _traits_t::cluster_t;
+	using cursor=shared_index_cursor<_traits_t>;
 	using iterator=shared_index_iterator<_traits_t, false>;
 	using const_iterator=shared_index_iterator<_traits_t, true>;
 
@@ -75,45 +142,68 @@ public:
 	shared_index()noexcept {}
 
 	// Access
-	inline const_iterator cfind(_item_t const& item, find_func func=find_func::equal)
+	template <class _key_param_t> inline const_iterator cfind(_key_param_t const& key, find_func func=find_func::equal)
 		{
 		const_iterator it(this);
-		it.find(item, func);
+		it.find(key, func);
 		return it;
 		}
-	inline bool contains(_item_t const& item)
+	template <class _key_param_t> inline bool contains(_key_param_t const& key)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
-		return _cluster_t::contains(item);
+		return this->m_mutex.read([&]() { return _cluster_t::contains(key); });
 		}
-	inline iterator find(_item_t const& item, find_func func=find_func::equal)
+	template <class _key_param_t> inline iterator find(_key_param_t const& key, find_func func=find_func::equal)
 		{
 		iterator it(this);
-		it.find(item, func);
+		it.find(key, func);
 		return it;
 		}
-	inline bool index_of(_item_t const& item, _size_t* pos_ptr)
+	template <class _key_param_t> inline bool index_of(_key_param_t const& key, _size_t* pos_ptr)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
-		return _cluster_t::index_of(item, pos_ptr);
+		return this->m_mutex.read([&]() { return _cluster_t::index_of(key, pos_ptr); });
 		}
 
 	// Modification
 	template <class _item_param_t> inline bool add(_item_param_t const& item)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::add(item);
 		}
-	inline bool remove(_item_t const& item)
+	inline _size_t add_many(_item_t const* items, _size_t count)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::add_many(items, count);
+		}
+	template <class _it_t> inline void assign_sorted(_it_t first, _it_t last)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		_cluster_t::assign_sorted(first, last);
+		}
+	template <class... _args_t> inline bool emplace(_args_t&&... args)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::emplace(std::forward<_args_t>(args)...);
+		}
+	template <class _key_param_t> inline _size_t erase_range(_key_param_t const& first, _key_param_t const& last)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
-		return _cluster_t::remove(item);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::erase_range(first, last);
+		}
+	template <class _key_param_t> inline bool remove(_key_param_t const& key)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::remove(key);
 		}
 	template <class _item_param_t> inline bool set(_item_param_t const& item)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::set(item);
 		}
+	inline _size_t set_many(_item_t const* items, _size_t count)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::set_many(items, count);
+		}
 };
 
 }
\ No newline at end of file
@@ -30,70 +30,152 @@ namespace Collections {
 // Shared List
 //=============
 
-template <typename _item_t, typename _size_t=uint32_t, uint16_t _group_size=10>
-class shared_list: public iterable_shared_cluster<list_traits<_item_t, _size_t, _group_size>>
+template <typename _item_t, typename _size_t=uint32_t, uint16_t _group_size=10, class _alloc_t=cluster_pool>
+class shared_list: public iterable_shared_cluster<list_traits<_item_t, _size_t, _group_size, _alloc_t>>
 {
 public:
 	// Using
-	using _traits_t=list_traits<_item_t, _size_t, _group_size>;
+	using _traits_t=list_traits<_item_t, _size_t, _group_size, _alloc_t>;
 	using _cluster_t=typename _traits_t::cluster_t;
+	using cursor=shared_cluster_cursor<_traits_t>;
 
 	// Con-/Destructors
-	shared_list()noexcept {}
+	shared_list()noexcept: m_combining(false), m_requests(nullptr) {}
 
 	// Access
 	inline bool contains(_item_t const& item)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
+		std::shared_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::contains(item);
 		}
 	inline _size_t get_many(_size_t position, _item_t* items, _size_t count)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
+		std::shared_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::get_many(position, items, count);
 		}
 	inline bool index_of(_item_t const& item, _size_t* position)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
+		std::shared_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::index_of(item, position);
 		}
 
 	// Modification
 	inline bool add(_item_t const& item)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::add(item);
 		}
 	inline void append(_item_t const& item)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		if(m_combining.load(std::memory_order_relaxed))
+			{
+			append_combined(item);
+			return;
+			}
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		_cluster_t::append(item);
 		}
 	inline void append(_item_t const* items, _size_t count)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		_cluster_t::append(items, count);
 		}
+	template <class... _args_t> inline void emplace_at(_size_t position, _args_t&&... args)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		_cluster_t::emplace_at(position, std::forward<_args_t>(args)...);
+		}
 	inline bool insert_at(_size_t position, _item_t const& item)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::insert_at(position, item);
 		}
 	inline bool remove(_item_t const& item)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::remove(item);
 		}
 	inline bool set_at(_size_t position, _item_t const& item)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::set_at(position, item);
 		}
 	inline _size_t set_many(_size_t position, _item_t const* items, _size_t count)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::set_many(position, items, count);
 		}
+
+	// Settings
+	inline void set_combining(bool combining)noexcept { m_combining.store(combining, std::memory_order_relaxed); }
+
+private:
+	// Request
+	struct append_request_t
+		{
+		append_request_t(_item_t const* item): item(item), next(nullptr), error(), done(false) {}
+		_item_t const* item;
+		append_request_t* next;
+		std::exception_ptr error;
+		std::atomic<bool> done;
+		};
+
+	// Common
+	void append_combined(_item_t const& item)
+		{
+		// Appends are queued and combined by the thread getting the lock.
+		append_request_t request(&item);
+		request.next=m_requests.load(std::memory_order_relaxed);
+		while(!m_requests.compare_exchange_weak(request.next, &request, std::memory_order_release, std::memory_order_relaxed));
+		while(!request.done.load(std::memory_order_acquire))
+			{
+			std::unique_lock<shared_cluster_mutex> lock(this->m_mutex, std::try_to_lock);
+			if(lock.owns_lock())
+				{
+				combine_appends();
+				continue;
+				}
+			std::this_thread::yield();
+			}
+		if(request.error)
+			std::rethrow_exception(request.error);
+		}
+	void combine_appends()
+		{
+		auto requests=m_requests.exchange(nullptr, std::memory_order_acquire);
+		if(!requests)
+			return;
+		append_request_t* first=nullptr;
+		while(requests)
+			{
+			auto next=requests->next;
+			requests->next=first;
+			first=requests;
+			requests=next;
+			}
+		std::exception_ptr error;
+		try
+			{
+			for(auto request=first; request; request=request->next)
+				m_buffer.push_back(*request->item);
+			_cluster_t::append(m_buffer.data(), (_size_t)m_buffer.size());
+			}
+		catch(...)
+			{
+			error=std::current_exception();
+			}
+		m_buffer.clear();
+		while(first)
+			{
+			auto next=first->next;
+			first->error=error;
+			first->done.store(true, std::memory_order_release);
+			first=next;
+			}
+		}
+	std::vector<_item_t> m_buffer;
+	std::atomic<bool> m_combining;
+	std::atomic<append_request_t*> m_requests;
 };
 
 }
\ No newline at end of file
@@ -16,7 +16,7 @@
 //=======
 
 #include "Collections/map.hpp"
-#include "Collections/shared_cluster.hpp"
+#include "Collections/shared_index.hpp"
 
 
 //===========
@@ -37,7 +37,7 @@ public:
 	// Using
 	using _base_t=shared_cluster_iterator<_traits_t, _is_const>;
 	using _item_t=typename _traits_t::item_t;
-	using _iterator_t=typename _traits_t::iterator_t;
+	using _iterator_t=typename std::conditional<_is_const, typename _traits_t::const_iterator_t, typename _traits_t::iterator_t>::type;
 	using _key_t=typename _traits_t::key_t;
 	using _value_t=typename _traits_t::value_t;
 
@@ -61,19 +61,264 @@ public:
 };
 
 
+//==============
+// Write-Result
+//==============
+
+enum class write_result
+{
+none,
+created,
+updated,
+removed
+};
+
+
+//=============
+// Write-Batch
+//=============
+
+// Modifications are collected without the lock and applied in order of their keys.
+// Modifications of the same key are applied in the order they were added,
+// runs of the same kind of modification are applied at once.
+
+template <typename _traits_t>
+class shared_map_batch
+{
+public:
+	// Using
+	using _item_t=typename _traits_t::item_t;
+	using _key_t=typename _traits_t::key_t;
+	using _order_t=index_order<typename _traits_t::compare_t>;
+	using _size_t=typename _traits_t::size_t;
+	using _value_t=typename _traits_t::value_t;
+
+	// Con-/Destructors
+	shared_map_batch() {}
+
+	// Access
+	inline _size_t get_count()const noexcept { return (_size_t)m_operations.size(); }
+	write_result get_result(_size_t position)const
+		{
+		if(position>=m_operations.size())
+			throw std::out_of_range("position");
+		return m_operations[position].result;
+		}
+
+	// Modification
+	template <class _key_param_t, class _value_param_t> inline void add(_key_param_t const& key, _value_param_t const& value)
+		{
+		push_item(operation_t::add, key, value);
+		}
+	template <class _cluster_t> _size_t apply(_cluster_t& cluster)
+		{
+		sort();
+		_size_t changed=0;
+		_size_t count=(_size_t)m_order.size();
+		_size_t start=0;
+		while(start<count)
+			{
+			operation_t type=m_operations[m_order[start]].type;
+			_size_t end=start+1;
+			while(end<count&&m_operations[m_order[end]].type==type)
+				end++;
+			switch(type)
+				{
+				case operation_t::add:
+					{
+					changed+=apply_add(cluster, start, end);
+					break;
+					}
+				case operation_t::remove:
+					{
+					changed+=apply_remove(cluster, start, end);
+					break;
+					}
+				case operation_t::set:
+					{
+					changed+=apply_set(cluster, start, end);
+					break;
+					}
+				}
+			start=end;
+			}
+		return changed;
+		}
+	void clear()noexcept
+		{
+		m_operations.clear();
+		m_items.clear();
+		m_keys.clear();
+		m_order.clear();
+		}
+	template <class _key_param_t> inline void remove(_key_param_t const& key)
+		{
+		m_keys.emplace_back(key);
+		m_operations.push_back({ operation_t::remove, (_size_t)(m_keys.size()-1), write_result::none });
+		}
+	template <class _key_param_t, class _value_param_t> inline void set(_key_param_t const& key, _value_param_t const& value)
+		{
+		push_item(operation_t::set, key, value);
+		}
+	void sort()
+		{
+		// The items are moved in order, so runs of additions can be passed on as a whole.
+		_size_t count=(_size_t)m_operations.size();
+		if(m_order.size()==count)
+			return;
+		m_order.resize(count);
+		for(_size_t u=0; u<count; u++)
+			m_order[u]=u;
+		std::stable_sort(m_order.begin(), m_order.end(), [this](_size_t first, _size_t second)
+			{
+			return _order_t::compare(get_key(m_operations[first]), get_key(m_operations[second]))<0;
+			});
+		std::vector<_item_t> items;
+		items.reserve(m_items.size());
+		for(_size_t pos: m_order)
+			{
+			auto& op=m_operations[pos];
+			if(op.type==operation_t::remove)
+				continue;
+			items.push_back(std::move(m_items[op.index]));
+			op.index=(_size_t)(items.size()-1);
+			}
+		m_items.swap(items);
+		}
+
+private:
+	// Operation
+	enum class operation_t
+		{
+		add,
+		remove,
+		set
+		};
+	struct write_op
+		{
+		operation_t type;
+		_size_t index;
+		write_result result;
+		};
+
+	// Access
+	inline _key_t const& get_key(write_op const& op)const noexcept
+		{
+		return op.type==operation_t::remove? m_keys[op.index]: m_items[op.index].get_key();
+		}
+	inline bool is_repeated(_size_t start, _size_t pos)const noexcept
+		{
+		if(pos==start)
+			return false;
+		return _order_t::compare(get_key(m_operations[m_order[pos-1]]), get_key(m_operations[m_order[pos]]))==0;
+		}
+
+	// Common
+	template <class _cluster_t> _size_t apply_add(_cluster_t& cluster, _size_t start, _size_t end)
+		{
+		// Only the first addition of a missing key creates an item.
+		_size_t created=0;
+		for(_size_t pos=start; pos<end; pos++)
+			{
+			auto& op=m_operations[m_order[pos]];
+			op.result=write_result::none;
+			if(is_repeated(start, pos))
+				continue;
+			if(cluster.contains(m_items[op.index].get_key()))
+				continue;
+			op.result=write_result::created;
+			created++;
+			}
+		auto first=m_operations[m_order[start]].index;
+		cluster.add_many(&m_items[first], end-start);
+		return created;
+		}
+	template <class _cluster_t> _size_t apply_remove(_cluster_t& cluster, _size_t start, _size_t end)
+		{
+		// Adjacent items are removed as a range, beginning at the back.
+		std::vector<_size_t> positions;
+		for(_size_t pos=start; pos<end; pos++)
+			{
+			auto& op=m_operations[m_order[pos]];
+			op.result=write_result::none;
+			if(is_repeated(start, pos))
+				continue;
+			_size_t position=0;
+			if(!cluster.index_of(m_keys[op.index], &position))
+				continue;
+			op.result=write_result::removed;
+			positions.push_back(position);
+			}
+		_size_t count=(_size_t)positions.size();
+		while(count>0)
+			{
+			_size_t last=positions[--count];
+			_size_t first=last;
+			while(count>0&&positions[count-1]+1==first)
+				first=positions[--count];
+			cluster.remove_range(first, last-first+1);
+			}
+		return (_size_t)positions.size();
+		}
+	template <class _cluster_t> _size_t apply_set(_cluster_t& cluster, _size_t start, _size_t end)
+		{
+		// Values are compared with the current one, the last value of a key is kept.
+		auto const& map=cluster;
+		_size_t changed=0;
+		for(_size_t pos=start; pos<end; pos++)
+			{
+			auto& op=m_operations[m_order[pos]];
+			auto const& item=m_items[op.index];
+			op.result=write_result::none;
+			if(is_repeated(start, pos))
+				{
+				if(m_items[op.index-1].get_value()==item.get_value())
+					continue;
+				}
+			else if(!map.contains(item.get_key()))
+				{
+				op.result=write_result::created;
+				changed++;
+				continue;
+				}
+			else if(map.get(item.get_key())==item.get_value())
+				{
+				continue;
+				}
+			op.result=write_result::updated;
+			changed++;
+			}
+		auto first=m_operations[m_order[start]].index;
+		cluster.set_many(&m_items[first], end-start);
+		return changed;
+		}
+	template <class _key_param_t, class _value_param_t> inline void push_item(operation_t type, _key_param_t const& key, _value_param_t const& value)
+		{
+		m_items.emplace_back(std::piecewise_construct, key, value);
+		m_operations.push_back({ type, (_size_t)(m_items.size()-1), write_result::none });
+		}
+	std::vector<write_op> m_operations;
+	std::vector<_item_t> m_items;
+	std::vector<_key_t> m_keys;
+	std::vector<_size_t> m_order;
+};
+
+
 //============
 // Shared Map
 //============
 
-template <typename _key_t, typename _value_t, typename _size_t=uint32_t, uint16_t _group_size=10>
-class shared_map: public iterable_shared_cluster<map_traits<_key_t, _value_t, _size_t, _group_size>>
+template <typename _key_t, typename _value_t, typename _size_t=uint32_t, uint16_t _group_size=10, class _alloc_t=cluster_pool, class _compare_t=index_compare>
+class shared_map: public iterable_shared_cluster<map_traits<_key_t, _value_t, _size_t, _group_size, _alloc_t, _compare_t>>
 {
 public:
 	// Using
-	using _traits_t=map_traits<_key_t, _value_t, _size_t, _group_size>;
+	using _traits_t=map_traits<_key_t, _value_t, _size_t, _group_size, _alloc_t, _compare_t>;
 	using _item_t=typename _traits_t::item_t;
 	using _cluster_t=typename _traits_t::cluster_t;
 	using _iterator_base_t=typename shared_cluster_iterator_base<_traits_t, false>::_base_t;
+	using batch=shared_map_batch<_traits_t>;
+	using cursor=shared_index_cursor<_traits_t>;
 	using iterator=shared_map_iterator<_traits_t, false>;
 	using const_iterator=shared_map_iterator<_traits_t, true>;
 
@@ -82,18 +327,17 @@ public:
 
 	// Access
 	template <class _key_param_t> inline _value_t operator[](_key_param_t const& key) { return get(key); }
-	inline const_iterator cfind(_key_t const& key, find_func func=find_func::equal)
+	template <class _key_param_t> inline const_iterator cfind(_key_param_t const& key, find_func func=find_func::equal)
 		{
 		const_iterator it(this);
 		it.find(key, func);
 		return it;
 		}
-	inline bool contains(_key_t const& key)
+	template <class _key_param_t> inline bool contains(_key_param_t const& key)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
-		return _cluster_t::contains(key);
+		return this->m_mutex.read([&]() { return _cluster_t::contains(key); });
 		}
-	inline iterator find(_key_t const& key, find_func func=find_func::equal)
+	template <class _key_param_t> inline iterator find(_key_param_t const& key, find_func func=find_func::equal)
 		{
 		iterator it(this);
 		it.find(key, func);
@@ -101,36 +345,70 @@ public:
 		}
 	template <class _key_param_t> inline _value_t get(_key_param_t const& key)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
+		// Missing values are created with the unique lock.
+		_value_t value;
+		if(this->m_mutex.read([&]() { return _cluster_t::try_get(key, &value); }))
+			return value;
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::get(key);
 		}
 	template <class _key_param_t> inline bool index_of(_key_param_t const& key, _size_t* pos_ptr)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
-		return _cluster_t::index_of(key, pos_ptr);
+		return this->m_mutex.read([&]() { return _cluster_t::index_of(key, pos_ptr); });
 		}
 	template <class _key_param_t> inline bool try_get(_key_param_t const& key, _value_t* value)
 		{
-		std::shared_lock<std::shared_mutex> lock(this->m_mutex);
-		return _cluster_t::try_get(key, value);
+		return this->m_mutex.read([&]() { return _cluster_t::try_get(key, value); });
 		}
 
 	// Modification
 	template <class _key_param_t, class _value_param_t> inline bool add(_key_param_t const& key, _value_param_t const& value)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::add(key, value);
 		}
-	inline bool remove(_key_t const& key)
+	inline _size_t add_many(_item_t const* items, _size_t count)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::add_many(items, count);
+		}
+	template <class _it_t> inline void assign_sorted(_it_t first, _it_t last)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		_cluster_t::assign_sorted(first, last);
+		}
+	template <class _key_param_t> inline _size_t erase_range(_key_param_t const& first, _key_param_t const& last)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::erase_range(first, last);
+		}
+	template <class _key_param_t> inline bool remove(_key_param_t const& key)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::remove(key);
 		}
 	template <class _key_param_t, class _value_param_t> inline bool set(_key_param_t const& key, _value_param_t const& value)
 		{
-		std::unique_lock<std::shared_mutex> lock(this->m_mutex);
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
 		return _cluster_t::set(key, value);
 		}
+	inline _size_t set_many(_item_t const* items, _size_t count)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::set_many(items, count);
+		}
+	template <class _key_param_t, class... _args_t> inline bool try_emplace(_key_param_t const& key, _args_t&&... args)
+		{
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return _cluster_t::try_emplace(key, std::forward<_args_t>(args)...);
+		}
+	_size_t write(batch& operations)
+		{
+		// The batch is sorted before taking the lock.
+		operations.sort();
+		std::unique_lock<shared_cluster_mutex> lock(this->m_mutex);
+		return operations.apply(*(_cluster_t*)this);
+		}
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+//=================
+// list_append.cpp
+//=================
+
+// Appending to lists after splitting and concatenating.
+
+// Copyright 2026, Sven Bieg (svenbieg@outlook.de)
+// https://github.com/svenbieg/Clusters/wiki/List
+
+
+//=======
+// Using
+//=======
+
+#include <stdio.h>
+#include "Collections/list.hpp"
+
+using namespace Collections;
+
+
+//========
+// Common
+//========
+
+static bool check_list(list<int>& list, int const* items, int count)
+{
+if(list.get_count()!=(uint32_t)count)
+	return false;
+int i=0;
+for(auto it=list.begin(); it.has_current(); it.move_next())
+	{
+	if(i==count||*it!=items[i++])
+		return false;
+	}
+return i==count;
+}
+
+
+//======
+// Main
+//======
+
+int main()
+{
+int items[75];
+for(int i=0; i<51; i++)
+	items[i]=i;
+for(int i=0; i<24; i++)
+	items[51+i]=i;
+int errors=0;
+
+// Children emptied by split_at() must not stay in front of the appended items.
+list<int> list;
+list.append(items, 51);
+for(int pos: { 6, 26, 47 })
+	{
+	auto tail=list.split_at(pos);
+	list.concat(std::move(tail));
+	}
+list.append(items, 24);
+if(!check_list(list, items, 75))
+	{
+	printf("append after split failed\n");
+	errors++;
+	}
+
+if(errors==0)
+	printf("ok\n");
+return errors;
+}
@@ -0,0 +1,83 @@
+//=================
+// list_concat.cpp
+//=================
+
+// Concatenation of lists with empty roots.
+
+// Copyright 2026, Sven Bieg (svenbieg@outlook.de)
+// https://github.com/svenbieg/Clusters/wiki/List
+
+
+//=======
+// Using
+//=======
+
+#include <stdio.h>
+#include "Collections/list.hpp"
+
+using namespace Collections;
+
+
+//========
+// Common
+//========
+
+static bool check_list(list<int>& list, int count)
+{
+// Empty leaves would stop the iteration.
+if(list.get_count()!=(uint32_t)count)
+	return false;
+for(int i=0; i<count; i++)
+	{
+	if(list.get_at(i)!=i)
+		return false;
+	}
+int i=0;
+for(auto it=list.begin(); it.has_current(); it.move_next())
+	{
+	if(*it!=i++)
+		return false;
+	}
+return i==count;
+}
+
+
+//======
+// Main
+//======
+
+int main()
+{
+int items[40];
+for(int i=0; i<40; i++)
+	items[i]=i;
+int errors=0;
+
+// Empty tail
+list<int> head;
+head.append(items, 40);
+list<int> tail;
+tail.append((int const*)nullptr, 0);
+head.concat(std::move(tail));
+if(!check_list(head, 40)||tail.get_root())
+	{
+	printf("empty tail failed\n");
+	errors++;
+	}
+
+// Empty head
+list<int> empty;
+empty.append((int const*)nullptr, 0);
+list<int> full;
+full.append(items, 40);
+empty.concat(std::move(full));
+if(!check_list(empty, 40)||full.get_root())
+	{
+	printf("empty head failed\n");
+	errors++;
+	}
+
+if(errors==0)
+	printf("ok\n");
+return errors;
+}